@@ -16,10 +16,15 @@ extern "C" {
 #endif
 
 /* =================== Includes =================== */
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/string.h> // Para memcpy
+#else
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <string.h> // Para memcpy
+#endif
 
 /* =================== Defines ==================== */
 // #define EXAMPLE_DEFINE 1
@@ -88,6 +93,25 @@ typedef struct {
 /* =================== Variables ================== */
 
 /* =================== Functions ================== */
+/**
+ * @fn      static inline void circular_buf_init(cbuf_handle_t* cbuf, void* storage, size_t capacity, size_t element_size)
+ * @brief   Inicializa un buffer circular sobre un almacenamiento reservado dinámicamente.
+ * @details Alternativa a CIRCULAR_BUF_DEFINE cuando la capacidad se conoce en tiempo de
+ * ejecución. El almacenamiento debe tener espacio para `capacity + 1` elementos.
+ * @param[out] cbuf         Puntero al handle del buffer que se va a inicializar.
+ * @param[in]  storage      Memoria para `capacity + 1` elementos de `element_size` bytes.
+ * @param[in]  capacity     Cantidad máxima de elementos que el buffer podrá contener.
+ * @param[in]  element_size Tamaño en bytes de un solo elemento.
+ */
+static inline void circular_buf_init(cbuf_handle_t* cbuf, void* storage,
+                                     size_t capacity, size_t element_size) {
+    cbuf->buffer = (uint8_t*)storage;
+    cbuf->head = 0;
+    cbuf->tail = 0;
+    cbuf->max_elements = capacity + 1;
+    cbuf->element_size = element_size;
+}
+
 /**
  * @fn      static inline void circular_buf_reset(cbuf_handle_t* cbuf)
  * @brief   Resetea el buffer a un estado vacío.
@@ -199,8 +223,52 @@ static inline bool circular_buf_pop(cbuf_handle_t* cbuf, void* data) {
     return true;
 }
 
+/**
+ * @fn      static inline bool circular_buf_push_overwrite(cbuf_handle_t* cbuf, const void* data)
+ * @brief   Añade un elemento descartando el más antiguo si el buffer está lleno.
+ * @details A diferencia de circular_buf_push(), el productor nunca falla: cuando no hay
+ * espacio se avanza `tail` antes de escribir. Tanto `head` como `tail` son modificados aquí,
+ * por lo que el consumidor debe serializarse con el productor (sección crítica externa).
+ * @param[in,out] cbuf  Puntero al handle del buffer.
+ * @param[in]     data  Puntero al elemento que se va a añadir.
+ * @return              true si se descartó el elemento más antiguo, false en caso contrario.
+ */
+static inline bool circular_buf_push_overwrite(cbuf_handle_t* cbuf, const void* data) {
+    bool overwritten = false;
+    if (circular_buf_is_full(cbuf)) {
+        cbuf->tail = (cbuf->tail + 1) % cbuf->max_elements;
+        overwritten = true;
+    }
+    memcpy(cbuf->buffer + (cbuf->head * cbuf->element_size), data, cbuf->element_size);
+    cbuf->head = (cbuf->head + 1) % cbuf->max_elements;
+    return overwritten;
+}
+
+/**
+ * @fn      static inline void circular_buf_read_at(cbuf_handle_t* cbuf, size_t index, void* data, size_t count)
+ * @brief   Copia `count` elementos a partir de una posición absoluta del array subyacente.
+ * @details No consulta `head` ni `tail`: el llamador decide qué posiciones son válidas (por
+ * ejemplo a partir de números de secuencia), lo que permite leer sin sección crítica y
+ * validar la copia después. Como mucho dos memcpy, uno por cada tramo contiguo.
+ * @param[in]  cbuf    Puntero al handle del buffer.
+ * @param[in]  index   Posición absoluta del primer elemento (0 .. max_elements - 1).
+ * @param[out] data    Destino con espacio para `count` elementos.
+ * @param[in]  count   Cantidad de elementos a copiar (como mucho max_elements).
+ */
+static inline void circular_buf_read_at(cbuf_handle_t* cbuf, size_t index, void* data, size_t count) {
+    size_t first = cbuf->max_elements - index;
+    uint8_t* dest = (uint8_t*)data;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dest, cbuf->buffer + (index * cbuf->element_size), first * cbuf->element_size);
+    if (count > first) {
+        memcpy(dest + (first * cbuf->element_size), cbuf->buffer, (count - first) * cbuf->element_size);
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif // CIRCULARBUFFER_H_
\ No newline at end of file
+#endif // CIRCULARBUFFER_H_
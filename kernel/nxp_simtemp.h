@@ -14,21 +14,25 @@
 
 #include <linux/device.h>
 #include <linux/mutex.h>
-#include <linux/timer.h>
+#include <linux/seqlock.h>
+#include <linux/atomic.h>
+#include <linux/hrtimer.h>
+#include <linux/cache.h>
+#include <linux/percpu.h>
+#include <linux/bitops.h>
+#include <linux/minmax.h>
 #include <linux/types.h>
 #include <linux/miscdevice.h>
 #include <linux/wait.h>     // Needed for wait_queue_head_t
 #include <linux/ktime.h>    // Needed for ktime_get_ns()
+#include <linux/prandom.h>
+#include <linux/numa.h>
+#include <linux/topology.h>
 
 #include "simtemp_debug.h"
 #include "nxp_simtemp_config.h"
-
-/* --- Flags for simtemp_sample --- */
-#define SIMTEMP_SAMPLE_FLAG_NEW             (1 << 0) /* Indicates a fresh sample */
-#define SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI    (1 << 1) /* Indicates threshold crossed */
-#define SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE    (2 << 1) /* Indicates threshold crossed */
-
-/* Add more flags as needed */
+#include "CircularBuffer.h"
+#include "nxp_simtemp_uapi.h"     /* simtemp_sample, flags, ring layout */
 
 /**
  * @brief Enumeration for the simulation modes.
@@ -37,49 +41,370 @@ enum simtemp_mode {
     SIMTEMP_MODE_NORMAL,
     SIMTEMP_MODE_NOISY,
     SIMTEMP_MODE_RAMP,
+    SIMTEMP_MODE_PROFILE,   /* Replay of the uploaded profile table */
     SIMTEMP_MODE_MAX,
 };
 
 /**
  * @brief Structure for holding driver statistics.
+ * One copy per CPU (simtemp->pcpu_stats), updated without locks with
+ * this_cpu ops; nxp_simtemp_stats_read() returns the sum over all CPUs.
  */
 struct simtemp_stats {
+    /* Producer */
     u64 updates;
     u64 alerts;
     u64 errors;
+    /* Readers */
+    u64 reads;          /* Successful read() calls */
+    u64 read_bytes;     /* Bytes returned by read() */
+    u64 read_eagain;    /* read() calls that returned -EAGAIN */
+    u64 read_timeouts;  /* Blocking read() calls that returned -ETIMEDOUT */
+    u64 dropped;        /* Samples overwritten before a read() consumer got them */
+};
+
+/**
+ * @brief Latency histograms, exported through debugfs.
+ */
+enum simtemp_lat_hist {
+    SIMTEMP_LAT_TIMER_JITTER,   /* Timer callback start vs. scheduled expiry */
+    SIMTEMP_LAT_WAKE_TO_READ,   /* Reader wake-up vs. end of copy_to_user (blocking reads) */
+    SIMTEMP_LAT_END_TO_END,     /* Sample timestamp vs. end of copy_to_user, per sample */
+    SIMTEMP_LAT_MAX,
+};
+
+/* log2 buckets: bucket b counts [2^(b-1), 2^b) ns, bucket 0 counts 0 ns, the last one is open-ended */
+#define SIMTEMP_LAT_BUCKETS 36
+
+/**
+ * @brief Per-CPU latency histograms of one instance.
+ */
+struct simtemp_latency {
+    u64 bucket[SIMTEMP_LAT_MAX][SIMTEMP_LAT_BUCKETS];
 };
 
+/* Lock-free statistics updates, safe from any context */
+#define simtemp_stat_inc(_simtemp, _field)  this_cpu_inc((_simtemp)->pcpu_stats->_field)
+#define simtemp_stat_add(_simtemp, _field, _val) \
+	this_cpu_add((_simtemp)->pcpu_stats->_field, (_val))
+
 /**
- * @brief Structure for a single temperature sample (binary record).
+ * @brief Runtime configuration, read by the producer as one snapshot.
  */
-struct simtemp_sample {
-	__u64 timestamp_ns;   /* Monotonic timestamp in nanoseconds */
-	__s32 temp_mc;        /* Temperature in milli-Celsius */
-	__u32 flags;          /* Status flags (e.g., new, threshold) */
-} __attribute__((packed)); /* Ensure no padding */
+struct simtemp_config {
+    u32 sampling_us;            /* Update period in microseconds */
+    s32 threshold_mc;           /* Alert threshold in milli-Celsius */
+    enum simtemp_mode mode;     /* Simulation mode */
+    u32 speed;                  /* Virtual clock rate, 1 = real time */
+    u32 hysteresis_mc;          /* Threshold alert clears at threshold_mc - hysteresis_mc */
+    u32 rate_mc_per_s;          /* dT/dt alert limit, 0 = off */
+    u32 agg_window_ms;          /* Aggregation window, 0 = off */
+};
+
+/**
+ * @brief Publication variants timed by the self-benchmark.
+ */
+enum simtemp_bench_lock {
+    SIMTEMP_BENCH_SEQCOUNT,     /* latest_sample write section (current producer) */
+    SIMTEMP_BENCH_SEQLOCK_READ, /* cfg_lock snapshot (current producer) */
+    SIMTEMP_BENCH_SPINLOCK,     /* spin_lock_bh() around the sample copy */
+    SIMTEMP_BENCH_MUTEX,        /* Mutex around the sample copy (original design) */
+    SIMTEMP_BENCH_LOCK_MAX,
+};
+
+/**
+ * @brief Report of one self-benchmark run (nxp_simtemp_bench.c).
+ */
+struct simtemp_bench_result {
+    u32 iterations;             /* Producer ticks run */
+    u32 readers;                /* Synthetic readers */
+    u32 lowat;                  /* Watermark of the readers */
+    u64 samples;                /* Samples generated */
+    u64 produce_ns;             /* Total time in nxp_simtemp_generate() */
+    u64 wake_ns;                /* Total time in nxp_simtemp_wake_readers() */
+    u64 tick_max_ns;            /* Slowest tick, generate + wake */
+    u64 consume_ns;             /* Total time the readers spent draining */
+    u64 wakeups;                /* Reader wake-ups issued */
+    u64 dropped;                /* Samples the readers lost */
+    u64 lock_uncontended_ns[SIMTEMP_BENCH_LOCK_MAX]; /* Mean cost per operation, single-threaded */
+};
+
+struct simtemp_dev;
+struct simtemp_group;
+struct simtemp_profile;
+struct iio_dev;
+
+/**
+ * @brief Producer-private generator state of one instance.
+ * Lives in the instance (per-instance timer) or, with the grouped engine, in
+ * the contiguous array of its group, one cache line per sensor so a group
+ * tick walks dense memory instead of every struct simtemp_dev.
+ */
+struct simtemp_gen {
+    struct simtemp_dev *simtemp;    /* Instance fed by this generator */
+    s32 temp_mc;                    /* Last generated temperature (ramp continuity) */
+    struct rnd_state rnd;           /* Noise PRNG, seeded once from the CRNG */
+    u64 profile_id;                 /* Profile table being replayed (0 = none yet) */
+    u64 profile_pos_us;             /* Position in the table, [0, duration) */
+    u32 profile_seg;                /* Segment containing profile_pos_us */
+    u64 clock_ns;                   /* Timestamp of the last generated sample */
+    u32 alert_state;                /* THRESHOLD_HI | RATE_HI of the last sample */
+    bool gap;                       /* Sampling was stopped: flag the next sample GAP */
+    /* Aggregation window being filled (nxp_simtemp_agg.c) */
+    u32 agg_window_ms;              /* Window length of the accumulator, 0 = off */
+    u32 agg_count;
+    u64 agg_start_ns;
+    u64 agg_end_ns;                 /* First timestamp of the next window */
+    s64 agg_sum_mc;
+    s32 agg_min_mc;
+    s32 agg_max_mc;
+    u32 agg_flags;
+} ____cacheline_aligned_in_smp;
 
 /**
  * @brief Main device structure for the simulated temperature sensor.
  */
 struct simtemp_dev {
     struct device *dev;         /* Pointer to the underlying device */
+    int id;                     /* Instance number, /dev/simtemp<id> */
+    char name[SIMTEMP_NAME_LEN];/* Misc device name */
     struct miscdevice misc_dev;    /* misc device's device struct */
-    struct mutex lock;          /* Mutex for protecting shared data */
-    struct timer_list timer;    /* Kernel timer for the simulator */
+    int cpu;                    /* Sampling CPU (timer pinned there), -1 = unbound */
+    struct hrtimer timer;       /* Periodic sampling timer (softirq, absolute expiries) */
+    ktime_t last_tick;          /* Expiry of the last per-instance tick (phase reference) */
+    struct simtemp_gen gen;     /* Generator state while not in a group */
+    struct simtemp_group *group;/* Grouped engine: group servicing this instance */
+    struct mutex sched_lock;    /* Serializes cfg writers and cpu stores with the re-arm */
+    struct mutex run_lock;      /* Serializes start, stop and re-arm of the sampling */
+    unsigned int users;         /* Lazy mode: open files and enabled IIO buffers */
+    bool enabled;               /* Between simulator init and exit: sampling may run */
+    bool running;               /* Sampling timer armed (or member of a group) */
 
-    /* Configuration */
-    u32 sampling_ms;            /* Update period in milliseconds */
-    s32 threshold_mc;           /* Alert threshold in milli-Celsius */
-    enum simtemp_mode mode;    /* Simulation mode */
+    /* Configuration: written by sysfs, snapshotted by the producer */
+    seqlock_t cfg_lock;         /* Writers serialize on it, readers retry */
+    struct simtemp_config cfg;
 
-    /* State for blocking read*/
+    /* Producer output: single writer (timer), readers retry on sample_seq */
+    seqcount_t sample_seq;      /* Protects latest_sample */
     struct simtemp_sample latest_sample;   /* Current temperature in milli-Celsius */
-    bool new_sample_available;             /* Flag indicating if a new sample is available */
-    wait_queue_head_t read_wq;             /* Wait queue for readers */
+    struct simtemp_stats __percpu *pcpu_stats; /* Statistics counters */
+    struct simtemp_latency __percpu *pcpu_latency; /* Latency histograms */
+    u64 last_wake_ns;           /* Last time readers were woken (wake-to-read) */
+    u64 clock_offset_ns;        /* Instance clock minus CLOCK_MONOTONIC; grows under fast replay */
+    u64 alert_seq;              /* Alert transitions so far (POLLPRI edges), written by the producer */
+    struct dentry *debugfs_dir; /* <debugfs>/nxp_simtemp/simtemp<id>/ */
+    struct mutex bench_lock;    /* One self-benchmark at a time, protects bench */
+    struct simtemp_bench_result bench; /* Last self-benchmark report */
+    spinlock_t files_lock;      /* Serializes changes of files */
+    struct list_head files;     /* Open files (struct simtemp_file), RCU-walked by the producer */
+    unsigned long read_timeout_jiffies;    /* Blocking read timeout */
 
-    struct simtemp_stats stats;/* Statistics counters */
+    /* Standard framework views of the instance (nxp_simtemp_hwmon.c, nxp_simtemp_iio.c) */
+    struct device *hwmon_dev;   /* hwmon device, NULL without hwmon support */
+    struct iio_dev *iio_dev;    /* IIO device, NULL without IIO support */
+    struct iio_dev __rcu *iio_active; /* Set while the IIO buffer is enabled */
+
+    /* Profile mode: compiled table, replaced as a whole under RCU */
+    struct simtemp_profile __rcu *profile;
+    struct mutex profile_lock;  /* Serializes uploads */
+    void *profile_staging;      /* Upload in progress, header + points */
+    size_t profile_staged;      /* Bytes received */
+    size_t profile_size;        /* Bytes expected */
+
+    /* Closed aggregation windows, single writer (producer) */
+    struct simtemp_agg_record *agg_ring; /* SIMTEMP_AGG_DEPTH records */
+    u64 agg_head;               /* Sequence number of the next record */
+
+    /* Sample FIFO shared by all readers (mmap()able, see nxp_simtemp_uapi.h) */
+    u32 depth;                  /* Samples to keep, set at probe (DT buffer-depth) */
+    u32 lowat;                  /* Watermark of newly opened files (DT watermark) */
+    struct simtemp_ring_hdr *ring; /* vmalloc_user area: header page + records */
+    size_t ring_size;           /* Size of the ring area in bytes */
+    cbuf_handle_t samples;      /* Records of the ring, oldest overwritten */
+};
+
+/**
+ * @brief Per-open-file state, stored in file->private_data.
+ */
+struct simtemp_file {
+    struct simtemp_dev *simtemp;    /* Device this file was opened on */
+    struct list_head node;          /* Entry in simtemp->files */
+    wait_queue_head_t wq;           /* Readers and pollers of this file */
+    struct hrtimer deadline_timer;  /* Wakes wq when max_latency_ns expires */
+    u32 lowat;                      /* Pending samples that make the file readable */
+    u64 max_latency_ns;             /* Age of the oldest pending sample that does too; 0 = off */
+    struct mutex read_lock;         /* Serializes readers sharing this file */
+    struct simtemp_ring_cursor *cursor; /* mmap()able page; consumer = next sample to return */
+    struct simtemp_sample *batch;   /* Bounce buffer: SIMTEMP_READ_BATCH_MAX samples */
+    u32 format;                     /* read() format, SIMTEMP_FORMAT_* */
+    void *frame;                    /* Encoded frame staging (delta format only) */
+    struct simtemp_agg_record *aggs; /* Bounce buffer, SIMTEMP_AGG_DEPTH records (agg format only) */
+    u64 agg_consumer;               /* Next window record to return (agg format) */
+    u64 alert_seen;                 /* alert_seq last consumed (read() or SIMTEMP_IOC_ACK_ALERT) */
+    struct rcu_head rcu;            /* Deferred free once the producer can no longer see the file */
 };
 
+/**
+ * @brief Adds a latency value to a histogram of an instance.
+ * Lock-free, safe from any context.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param hist Histogram to update.
+ * @param delta_ns Latency in nanoseconds; negative values count as 0.
+ */
+static inline void nxp_simtemp_latency_record(struct simtemp_dev *simtemp,
+                                              enum simtemp_lat_hist hist, s64 delta_ns)
+{
+    unsigned int b = delta_ns > 0 ? fls64(delta_ns) : 0;
+
+    this_cpu_inc(simtemp->pcpu_latency->bucket[hist][min_t(unsigned int, b, SIMTEMP_LAT_BUCKETS - 1)]);
+}
+
+/**
+ * @brief Current time on the clock of an instance.
+ * Sample timestamps use this clock: CLOCK_MONOTONIC plus an offset that only
+ * grows while the instance runs faster than real time (speed > 1).
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return Instance time in nanoseconds.
+ */
+static inline u64 nxp_simtemp_clock_ns(struct simtemp_dev *simtemp)
+{
+    return ktime_get_ns() + READ_ONCE(simtemp->clock_offset_ns);
+}
+
+/**
+ * @brief Real time between two generated samples.
+ * sampling_us of virtual time divided by the speed, never below
+ * SIMTEMP_SAMPLING_US_MIN, which caps the effective speed.
+ * @param cfg Configuration snapshot.
+ * @return Emission period in microseconds.
+ */
+static inline u32 nxp_simtemp_emit_period_us(const struct simtemp_config *cfg)
+{
+    return max_t(u32, cfg->sampling_us / cfg->speed, SIMTEMP_SAMPLING_US_MIN);
+}
+
+/**
+ * @brief Samples generated per timer tick for a sampling period.
+ * Periods below SIMTEMP_TICK_US_MIN are generated in blocks so the timer
+ * never fires more often than every SIMTEMP_TICK_US_MIN.
+ * @param sampling_us Emission period in microseconds.
+ * @return Block size, 1..SIMTEMP_GEN_BLOCK_MAX.
+ */
+static inline u32 nxp_simtemp_gen_block(u32 sampling_us)
+{
+    return clamp_t(u32, DIV_ROUND_UP(SIMTEMP_TICK_US_MIN, sampling_us), 1, SIMTEMP_GEN_BLOCK_MAX);
+}
+
+/**
+ * @brief Memory node of a sampling CPU.
+ * @param cpu Sampling CPU, or -1 for unbound.
+ * @return NUMA node, or NUMA_NO_NODE for an unbound instance.
+ */
+static inline int nxp_simtemp_cpu_node(int cpu)
+{
+    return cpu < 0 ? NUMA_NO_NODE : cpu_to_node(cpu);
+}
+
+/**
+ * @brief Memory node of an instance: the node of its sampling CPU.
+ * Producer-side buffers are allocated there, so the timer and consumers
+ * pinned next to it keep their memory traffic on one node.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return NUMA node, or NUMA_NO_NODE for an unbound instance.
+ */
+static inline int nxp_simtemp_node(struct simtemp_dev *simtemp)
+{
+    return nxp_simtemp_cpu_node(READ_ONCE(simtemp->cpu));
+}
+
+/* --- Configuration attributes (nxp_simtemp_sysfs.c) --- */
+extern const char * const nxp_simtemp_modes[SIMTEMP_MODE_MAX]; /* "mode" attribute / DT values */
+
+/* --- Sample generation (nxp_simtemp_simulator.c) --- */
+u32 nxp_simtemp_generate(struct simtemp_gen *gen, u64 now_ns);
+void nxp_simtemp_timer_start(struct hrtimer *timer, ktime_t expires, int cpu);
+void nxp_simtemp_wake_readers(struct simtemp_dev *simtemp);
+int nxp_simtemp_simulator_update(struct simtemp_dev *simtemp);
+int nxp_simtemp_simulator_get(struct simtemp_dev *simtemp);
+void nxp_simtemp_simulator_put(struct simtemp_dev *simtemp);
+
+/* --- Grouped sampling engine (nxp_simtemp_engine.c) --- */
+int nxp_simtemp_engine_attach(struct simtemp_dev *simtemp, u32 period_us);
+void nxp_simtemp_engine_detach(struct simtemp_dev *simtemp);
+
+/* --- Publication API (nxp_simtemp_locks.c) --- */
+void nxp_simtemp_config_read(struct simtemp_dev *simtemp, struct simtemp_config *cfg);
+void nxp_simtemp_sample_read(struct simtemp_dev *simtemp, struct simtemp_sample *latest);
+void nxp_simtemp_sample_publish(struct simtemp_dev *simtemp, const struct simtemp_sample *latest);
+
+/* --- Profile mode (nxp_simtemp_profile.c) --- */
+ssize_t nxp_simtemp_profile_write(struct simtemp_dev *simtemp, const char *buf,
+                                  loff_t off, size_t count);
+bool nxp_simtemp_profile_loaded(struct simtemp_dev *simtemp);
+void nxp_simtemp_profile_fill(struct simtemp_gen *gen, s32 *temps, u32 n, u32 step_us);
+
+/* --- Windowed aggregation (nxp_simtemp_agg.c) --- */
+void nxp_simtemp_agg_fold(struct simtemp_gen *gen, u32 window_ms, const struct simtemp_sample *sample);
+size_t nxp_simtemp_agg_pop(struct simtemp_dev *simtemp, u64 *seq,
+                           struct simtemp_agg_record *recs, size_t max);
+bool nxp_simtemp_agg_has_data(struct simtemp_dev *simtemp, u64 seq);
+u64 nxp_simtemp_agg_head(struct simtemp_dev *simtemp);
+
+/* --- IIO buffered interface (nxp_simtemp_iio.c) --- */
+/* Optional frameworks, registered when the kernel provides them */
+#define SIMTEMP_HAVE_IIO    (IS_REACHABLE(CONFIG_IIO) && IS_REACHABLE(CONFIG_IIO_KFIFO_BUF))
+#define SIMTEMP_HAVE_HWMON  IS_REACHABLE(CONFIG_HWMON)
+
+#if SIMTEMP_HAVE_IIO
+void nxp_simtemp_iio_push(struct simtemp_dev *simtemp, const struct simtemp_sample *sample);
+#else
+static inline void nxp_simtemp_iio_push(struct simtemp_dev *simtemp,
+                                        const struct simtemp_sample *sample)
+{
+}
+#endif
+
+/* --- Producer self-benchmark (nxp_simtemp_bench.c) --- */
+int nxp_simtemp_bench_run(struct simtemp_dev *simtemp, u32 iterations, u32 readers,
+                          u32 lowat, struct simtemp_bench_result *res);
+
+/* --- Readers (nxp_simtemp_miscdev.c) --- */
+bool nxp_simtemp_file_ready(struct simtemp_file *sfile, u64 now_ns);
+
+/**
+ * @brief Checks whether a file has an alert transition it was not told about.
+ * @param sfile Per-file state.
+ * @return true if POLLPRI is pending for the file.
+ */
+static inline bool nxp_simtemp_file_alert(struct simtemp_file *sfile)
+{
+    return READ_ONCE(sfile->simtemp->alert_seq) != READ_ONCE(sfile->alert_seen);
+}
+
+/* --- Statistics (nxp_simtemp_stats.c) --- */
+void nxp_simtemp_stats_read(struct simtemp_dev *simtemp, struct simtemp_stats *stats);
+void nxp_simtemp_latency_read(struct simtemp_dev *simtemp, enum simtemp_lat_hist hist,
+                              u64 buckets[SIMTEMP_LAT_BUCKETS]);
+void nxp_simtemp_latency_reset(struct simtemp_dev *simtemp);
+
+/* --- Stream formats (nxp_simtemp_format.c) --- */
+/* Worst-case size of one SIMTEMP_FORMAT_DELTA_V1 frame */
+#define SIMTEMP_FRAME_MAX (sizeof(struct simtemp_frame_hdr) + \
+                           (SIMTEMP_READ_BATCH_MAX - 1) * SIMTEMP_DELTA_RECORD_MAX)
+size_t nxp_simtemp_format_encode(const struct simtemp_sample *samples, size_t n,
+                                 void *out, size_t size, size_t *len);
+
+/* --- Sample buffer API (nxp_simtemp_buffer.c) --- */
+struct vm_area_struct;
+void nxp_simtemp_buffer_push(struct simtemp_dev *simtemp, const struct simtemp_sample *sample);
+size_t nxp_simtemp_buffer_pop(struct simtemp_dev *simtemp, u64 *read_seq,
+                              struct simtemp_sample *samples, size_t max);
+bool nxp_simtemp_buffer_has_data(struct simtemp_dev *simtemp, u64 read_seq);
+u64 nxp_simtemp_buffer_pending(struct simtemp_dev *simtemp, u64 read_seq, u64 *oldest_ns);
+u64 nxp_simtemp_buffer_head(struct simtemp_dev *simtemp);
+u64 nxp_simtemp_buffer_seek(struct simtemp_dev *simtemp, u64 since_ns);
+int nxp_simtemp_buffer_mmap(struct simtemp_dev *simtemp, struct vm_area_struct *vma);
+
 
 
 #endif /* NXP_SIMTEMP_H_ */
\ No newline at end of file
@@ -0,0 +1,198 @@
+/**
+ * @file    nxp_simtemp_agg.c
+ * @author  Omar Mendiola
+ * @brief   Windowed aggregation of the NXP simtemp driver.
+ * With agg_window_ms set, the producer folds every sample into the
+ * min/max/mean/count of its window (aligned on the instance clock) and
+ * queues one struct simtemp_agg_record per closed window in a small ring.
+ * Files switched to SIMTEMP_FORMAT_AGG_V1 read those records instead of
+ * raw samples, so summary consumers are woken and copy data once per window
+ * whatever the sampling rate. The ring follows the lock-free protocol of
+ * the sample FIFO (see nxp_simtemp_buffer.c).
+ * @version 0.1
+ * @date    2025-10-28
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/limits.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "nxp_simtemp.h"
+
+/* One slot stays free so a copy racing with the producer can be detected */
+#define SIMTEMP_AGG_CAPACITY    (SIMTEMP_AGG_DEPTH - 1)
+
+/**
+ * @brief Queues the record of the window being closed.
+ * The record is written before agg_head is published, as in
+ * nxp_simtemp_buffer_push().
+ * @param gen Generator state holding the window.
+ */
+static void simtemp_agg_push(struct simtemp_gen *gen)
+{
+	struct simtemp_dev *simtemp = gen->simtemp;
+	struct simtemp_agg_record *rec;
+	u64 head = simtemp->agg_head;
+
+	smp_wmb(); /* Order the last head store before overwriting a slot */
+	rec = &simtemp->agg_ring[head % SIMTEMP_AGG_DEPTH];
+	rec->start_ns = gen->agg_start_ns;
+	rec->window_us = gen->agg_window_ms * USEC_PER_MSEC;
+	rec->count = gen->agg_count;
+	rec->min_mc = gen->agg_min_mc;
+	rec->max_mc = gen->agg_max_mc;
+	rec->mean_mc = (s32)div_s64(gen->agg_sum_mc, gen->agg_count);
+	rec->flags = gen->agg_flags;
+	smp_store_release(&simtemp->agg_head, head + 1);
+}
+
+/**
+ * @brief Folds one sample into the current window.
+ *
+ * Called by the producer for every sample while aggregation is on. A
+ * sample past the end of the window closes it and opens the window holding
+ * the sample. A change of the window length drops the partial window.
+ * Runs in softirq context.
+ *
+ * @param gen Generator state of the instance.
+ * @param window_ms Configured window (0 = off).
+ * @param sample Sample just generated.
+ */
+void nxp_simtemp_agg_fold(struct simtemp_gen *gen, u32 window_ms, const struct simtemp_sample *sample)
+{
+	u64 window_ns, rem;
+
+	if (window_ms != gen->agg_window_ms) {
+		gen->agg_window_ms = window_ms;
+		gen->agg_count = 0;
+		gen->agg_end_ns = 0;
+	}
+	if (!window_ms)
+		return;
+
+	if (sample->timestamp_ns >= gen->agg_end_ns) {
+		if (gen->agg_count)
+			simtemp_agg_push(gen);
+		window_ns = (u64)window_ms * NSEC_PER_MSEC;
+		div64_u64_rem(sample->timestamp_ns, window_ns, &rem);
+		gen->agg_start_ns = sample->timestamp_ns - rem;
+		gen->agg_end_ns = gen->agg_start_ns + window_ns;
+		gen->agg_count = 0;
+		gen->agg_sum_mc = 0;
+		gen->agg_min_mc = S32_MAX;
+		gen->agg_max_mc = S32_MIN;
+		gen->agg_flags = 0;
+	}
+
+	gen->agg_count++;
+	gen->agg_sum_mc += sample->temp_mc;
+	gen->agg_min_mc = min(gen->agg_min_mc, sample->temp_mc);
+	gen->agg_max_mc = max(gen->agg_max_mc, sample->temp_mc);
+	gen->agg_flags |= sample->flags;
+}
+
+/**
+ * @brief Copies up to @max unread window records and advances a cursor.
+ *
+ * Same validation as nxp_simtemp_buffer_pop(): records overwritten before
+ * or during the copy are skipped and counted as dropped. Concurrent pops
+ * on the same cursor must be serialized by the caller.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param seq Reader cursor (sequence number of the next record to return).
+ * @param recs Destination array, at least @max entries.
+ * @param max Maximum number of records to copy.
+ * @return Number of records copied (0 if the reader is up to date).
+ */
+size_t nxp_simtemp_agg_pop(struct simtemp_dev *simtemp, u64 *seq,
+                           struct simtemp_agg_record *recs, size_t max)
+{
+	u64 head, next, lost;
+	size_t n, i;
+
+retry:
+	head = smp_load_acquire(&simtemp->agg_head);
+	next = *seq;
+	if ((s64)(head - next) <= 0) {
+		*seq = head;
+		return 0;
+	}
+
+	if (head - next > SIMTEMP_AGG_CAPACITY) {
+		lost = head - next - SIMTEMP_AGG_CAPACITY;
+		simtemp_stat_add(simtemp, dropped, lost);
+		next += lost;
+	}
+
+	n = min_t(u64, head - next, max);
+	for (i = 0; i < n; i++)
+		recs[i] = simtemp->agg_ring[(next + i) % SIMTEMP_AGG_DEPTH];
+
+	smp_rmb(); /* Finish the copy before rechecking agg_head */
+	head = READ_ONCE(simtemp->agg_head);
+	if (head - next > SIMTEMP_AGG_CAPACITY) {
+		/* Leading records were overwritten while copying and may be torn */
+		lost = min_t(u64, head - next - SIMTEMP_AGG_CAPACITY, n);
+		simtemp_stat_add(simtemp, dropped, lost);
+		next += lost;
+		n -= lost;
+		if (!n) {
+			*seq = next;
+			goto retry;
+		}
+		memmove(recs, recs + lost, n * sizeof(*recs));
+	}
+
+	*seq = next + n;
+	return n;
+}
+
+/**
+ * @brief Checks whether a reader has unread window records.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param seq Reader cursor.
+ * @return true if at least one record is pending.
+ */
+bool nxp_simtemp_agg_has_data(struct simtemp_dev *simtemp, u64 seq)
+{
+	return (s64)(smp_load_acquire(&simtemp->agg_head) - seq) > 0;
+}
+
+/**
+ * @brief Returns the sequence number of the next window record.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return Current head sequence number.
+ */
+u64 nxp_simtemp_agg_head(struct simtemp_dev *simtemp)
+{
+	return smp_load_acquire(&simtemp->agg_head);
+}
+
+/**
+ * @brief Allocates the window record ring.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or -ENOMEM.
+ */
+int nxp_simtemp_agg_init(struct simtemp_dev *simtemp)
+{
+	simtemp->agg_ring = kcalloc_node(SIMTEMP_AGG_DEPTH, sizeof(*simtemp->agg_ring), GFP_KERNEL,
+	                                 nxp_simtemp_node(simtemp));
+	if (!simtemp->agg_ring)
+		return -ENOMEM;
+	simtemp->agg_head = 0;
+	return 0;
+}
+
+/**
+ * @brief Releases the window record ring.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_agg_exit(struct simtemp_dev *simtemp)
+{
+	kfree(simtemp->agg_ring);
+	simtemp->agg_ring = NULL;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file    nxp_simtemp_bench.c
+ * @author  Omar Mendiola
+ * @brief   Producer self-benchmark of the NXP simtemp driver.
+ * Runs the tick of the per-instance timer (nxp_simtemp_generate() with the
+ * buffer push, then nxp_simtemp_wake_readers()) in a tight loop against a
+ * scratch device that copies the configuration of the instance, with
+ * synthetic readers whose wait queue entries count wake-ups instead of
+ * waking a task. The live instance, its readers and its statistics are not
+ * touched. Triggered from <debugfs>/nxp_simtemp/simtemp<id>/bench.
+ * @version 0.1
+ * @date    2025-10-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/bottom_half.h>
+#include <linux/math64.h>
+#include <linux/random.h>
+#include <linux/rculist.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include "nxp_simtemp.h"
+
+extern void nxp_simtemp_locks_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_locks_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_stats_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_stats_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_buffer_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_buffer_exit(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_profile_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_profile_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_agg_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_agg_exit(struct simtemp_dev *simtemp);
+
+/* Ticks between two reschedule points of the benchmark loop */
+#define SIMTEMP_BENCH_RESCHED   256
+
+/* Instance number of the scratch device, never a live one, so its tracepoints stand apart */
+#define SIMTEMP_BENCH_ID        (-1)
+
+/**
+ * @brief Synthetic reader: an open file with a permanent waiter.
+ */
+struct simtemp_bench_reader {
+	struct simtemp_file file;
+	struct simtemp_ring_cursor cursor;
+	struct wait_queue_entry wait;   /* Keeps wq_has_sleeper() true */
+	bool woken;
+};
+
+/* Wake function of a synthetic reader: record the wake-up, wake no task */
+static int simtemp_bench_wake(struct wait_queue_entry *wait, unsigned int mode, int sync, void *key)
+{
+	struct simtemp_bench_reader *reader = container_of(wait, struct simtemp_bench_reader, wait);
+
+	reader->woken = true;
+	return 0;
+}
+
+/**
+ * @brief Builds the scratch device the producer runs against.
+ * @param simtemp Live instance whose configuration is copied.
+ * @return The scratch device, or NULL on allocation failure.
+ */
+static struct simtemp_dev *simtemp_bench_dev_create(struct simtemp_dev *simtemp)
+{
+	struct simtemp_dev *bench;
+
+	bench = kzalloc(sizeof(*bench), GFP_KERNEL);
+	if (!bench)
+		return NULL;
+
+	bench->dev = simtemp->dev;
+	bench->id = SIMTEMP_BENCH_ID;
+	bench->cpu = READ_ONCE(simtemp->cpu); /* Same memory placement as the instance */
+	bench->depth = simtemp->depth;
+	nxp_simtemp_locks_init(bench);
+	nxp_simtemp_profile_init(bench); /* No table: profile mode holds the temperature */
+	if (nxp_simtemp_stats_init(bench))
+		goto err_free;
+	if (nxp_simtemp_buffer_init(bench))
+		goto err_stats;
+	if (nxp_simtemp_agg_init(bench))
+		goto err_buffer;
+
+	nxp_simtemp_config_read(simtemp, &bench->cfg);
+	spin_lock_init(&bench->files_lock);
+	INIT_LIST_HEAD(&bench->files);
+	bench->gen.simtemp = bench;
+	bench->gen.temp_mc = SIMTEMP_TEMPERATURE_MC_INITIAL;
+	prandom_seed_state(&bench->gen.rnd, get_random_u64());
+	return bench;
+
+err_buffer:
+	nxp_simtemp_buffer_exit(bench);
+err_stats:
+	nxp_simtemp_stats_exit(bench);
+err_free:
+	nxp_simtemp_profile_exit(bench);
+	nxp_simtemp_locks_exit(bench);
+	kfree(bench);
+	return NULL;
+}
+
+static void simtemp_bench_dev_destroy(struct simtemp_dev *bench)
+{
+	nxp_simtemp_agg_exit(bench);
+	nxp_simtemp_buffer_exit(bench);
+	nxp_simtemp_stats_exit(bench);
+	nxp_simtemp_profile_exit(bench);
+	nxp_simtemp_locks_exit(bench);
+	kfree(bench);
+}
+
+/**
+ * @brief Times the publication variants, uncontended.
+ * Single-threaded lock/unlock pairs: the per-operation cost when no other
+ * CPU holds the lock, not a hold time or a contended wait. The seqcount
+ * and seqlock variants are the ones the producer uses; the
+ * spinlock and mutex variants copy the same sample under a lock, as a
+ * design where readers and the producer shared a lock would. Every variant
+ * but the mutex runs with BHs disabled, as in the timer.
+ * @param bench Scratch device.
+ * @param res Receives lock_uncontended_ns[].
+ */
+static void simtemp_bench_locks(struct simtemp_dev *bench, struct simtemp_bench_result *res)
+{
+	struct simtemp_sample sample = bench->latest_sample;
+	struct simtemp_config cfg;
+	spinlock_t lock;
+	struct mutex mutex;
+	u64 start;
+	u32 i;
+
+	spin_lock_init(&lock);
+	mutex_init(&mutex);
+	local_bh_disable();
+	start = ktime_get_ns();
+	for (i = 0; i < SIMTEMP_BENCH_LOCK_OPS; i++)
+		nxp_simtemp_sample_publish(bench, &sample);
+	res->lock_uncontended_ns[SIMTEMP_BENCH_SEQCOUNT] = ktime_get_ns() - start;
+
+	start = ktime_get_ns();
+	for (i = 0; i < SIMTEMP_BENCH_LOCK_OPS; i++)
+		nxp_simtemp_config_read(bench, &cfg);
+	res->lock_uncontended_ns[SIMTEMP_BENCH_SEQLOCK_READ] = ktime_get_ns() - start;
+	local_bh_enable();
+
+	start = ktime_get_ns();
+	for (i = 0; i < SIMTEMP_BENCH_LOCK_OPS; i++) {
+		spin_lock_bh(&lock);
+		bench->latest_sample = sample;
+		spin_unlock_bh(&lock);
+	}
+	res->lock_uncontended_ns[SIMTEMP_BENCH_SPINLOCK] = ktime_get_ns() - start;
+
+	start = ktime_get_ns();
+	for (i = 0; i < SIMTEMP_BENCH_LOCK_OPS; i++) {
+		mutex_lock(&mutex);
+		bench->latest_sample = sample;
+		mutex_unlock(&mutex);
+	}
+	res->lock_uncontended_ns[SIMTEMP_BENCH_MUTEX] = ktime_get_ns() - start;
+	mutex_destroy(&mutex);
+
+	for (i = 0; i < SIMTEMP_BENCH_LOCK_MAX; i++)
+		res->lock_uncontended_ns[i] = div_u64(res->lock_uncontended_ns[i], SIMTEMP_BENCH_LOCK_OPS);
+}
+
+/**
+ * @brief Runs the producer path in a tight loop and reports its cost.
+ *
+ * Every iteration is one timer tick: generate the block of samples (config
+ * snapshot, alerts, buffer push, latest_sample publication) and wake the
+ * ready readers, both with BHs disabled as in the softirq timer. The
+ * instance clock advances by one tick per iteration without any waiting.
+ * Woken readers then drain the ring through nxp_simtemp_buffer_pop(), as
+ * read() would, outside the timed producer section. Sleeps in between, so
+ * it must be called from process context; a fatal signal aborts the run.
+ *
+ * @param simtemp Instance whose configuration is benchmarked.
+ * @param iterations Producer ticks.
+ * @param readers Synthetic readers.
+ * @param lowat Watermark of the readers, in samples.
+ * @param res Receives the report.
+ * @return int 0 on success, -ENOMEM or -EINTR.
+ */
+int nxp_simtemp_bench_run(struct simtemp_dev *simtemp, u32 iterations, u32 readers,
+                          u32 lowat, struct simtemp_bench_result *res)
+{
+	struct simtemp_bench_reader *reader;
+	struct simtemp_sample *batch;
+	struct simtemp_stats stats;
+	struct simtemp_dev *bench;
+	u64 now_ns, t0, t1, t2;
+	u32 i, r, tick_us;
+	int ret = 0;
+
+	memset(res, 0, sizeof(*res));
+	res->iterations = iterations;
+	res->readers = readers;
+	res->lowat = lowat;
+
+	bench = simtemp_bench_dev_create(simtemp);
+	if (!bench)
+		return -ENOMEM;
+
+	reader = kvcalloc(readers, sizeof(*reader), GFP_KERNEL);
+	batch = kmalloc_array(SIMTEMP_READ_BATCH_MAX, sizeof(*batch), GFP_KERNEL);
+	if (!reader || !batch) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (r = 0; r < readers; r++) {
+		reader[r].file.simtemp = bench;
+		reader[r].file.cursor = &reader[r].cursor;
+		reader[r].file.lowat = lowat;
+		init_waitqueue_head(&reader[r].file.wq);
+		init_waitqueue_func_entry(&reader[r].wait, simtemp_bench_wake);
+		add_wait_queue(&reader[r].file.wq, &reader[r].wait);
+		list_add_tail_rcu(&reader[r].file.node, &bench->files);
+	}
+
+	now_ns = ktime_get_ns();
+	bench->gen.clock_ns = now_ns;
+	for (i = 0; i < iterations; i++) {
+		local_bh_disable();
+		t0 = ktime_get_ns();
+		tick_us = nxp_simtemp_generate(&bench->gen, now_ns);
+		t1 = ktime_get_ns();
+		nxp_simtemp_wake_readers(bench);
+		t2 = ktime_get_ns();
+		local_bh_enable();
+
+		res->produce_ns += t1 - t0;
+		res->wake_ns += t2 - t1;
+		res->tick_max_ns = max(res->tick_max_ns, t2 - t0);
+		now_ns += (u64)tick_us * NSEC_PER_USEC;
+
+		for (r = 0; r < readers; r++) {
+			if (!reader[r].woken)
+				continue;
+			reader[r].woken = false;
+			res->wakeups++;
+			/* As read() does, consume the alert transitions */
+			reader[r].file.alert_seen = READ_ONCE(bench->alert_seq);
+			while (nxp_simtemp_buffer_pop(bench, &reader[r].cursor.consumer, batch,
+			                              SIMTEMP_READ_BATCH_MAX))
+				;
+		}
+		res->consume_ns += ktime_get_ns() - t2;
+
+		if (!(i % SIMTEMP_BENCH_RESCHED)) {
+			if (fatal_signal_pending(current)) {
+				ret = -EINTR;
+				break;
+			}
+			cond_resched();
+		}
+	}
+
+	nxp_simtemp_stats_read(bench, &stats);
+	res->samples = stats.updates;
+	res->dropped = stats.dropped;
+	if (!ret)
+		simtemp_bench_locks(bench, res);
+
+	/* The loop above was the only RCU walker of the list */
+	for (r = 0; r < readers; r++)
+		remove_wait_queue(&reader[r].file.wq, &reader[r].wait);
+out:
+	kfree(batch);
+	kvfree(reader);
+	simtemp_bench_dev_destroy(bench);
+	return ret;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file    nxp_simtemp_buffer.c
+ * @author  Omar Mendiola
+ * @brief   Sample FIFO shared by all readers of a simtemp device.
+ * The producer (timer) pushes every sample into a CircularBuffer.h ring,
+ * overwriting the oldest one when full. Each open file keeps its own
+ * sequence cursor, so every reader sees the full stream. The ring lives in
+ * a vmalloc_user() area so it can also be mmap()ed read-only by userspace
+ * (layout in nxp_simtemp_uapi.h), allocated on the node of the sampling CPU.
+ * @version 0.2
+ * @date    2025-10-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#include "nxp_simtemp.h"
+
+/* The header gets its own page so records start page aligned */
+#define SIMTEMP_RING_HDR_SIZE   PAGE_SIZE
+
+/**
+ * @brief Pushes a new sample into the device FIFO.
+ *
+ * Called from the timer callback, the only writer of the ring, so no lock
+ * is taken. If the ring is full the oldest sample is discarded; readers that
+ * still pointed at it notice on their next pop. The record is written before
+ * producer is published, and the previous producer store is ordered before
+ * the record write, so readers can validate their copies (see struct
+ * simtemp_ring_hdr).
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param sample Sample to store.
+ */
+void nxp_simtemp_buffer_push(struct simtemp_dev *simtemp, const struct simtemp_sample *sample)
+{
+	struct simtemp_ring_hdr *ring = simtemp->ring;
+
+	smp_wmb(); /* Order the last producer store before overwriting a slot */
+	circular_buf_push_overwrite(&simtemp->samples, sample);
+	smp_store_release(&ring->producer, ring->producer + 1);
+}
+
+/**
+ * @brief Copies up to @max unread samples for a reader and advances its cursor.
+ *
+ * Lock-free: follows the same protocol as mmap() clients. Records are copied
+ * after an acquire load of producer and revalidated against a second load;
+ * records the producer overwrote during the copy are discarded. If the
+ * reader fell behind by more than the ring capacity, its cursor is moved to
+ * the oldest sample still stored. Both cases are accounted in the
+ * dropped statistic. The cursor may live in a page userspace can write, so a
+ * cursor ahead of the producer is reset to it.
+ *
+ * Concurrent pops on the same cursor must be serialized by the caller.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param read_seq Reader cursor (sequence number of the next sample to return).
+ * @param samples Destination array, at least @max entries.
+ * @param max Maximum number of samples to copy.
+ * @return Number of samples copied (0 if the reader is up to date).
+ */
+size_t nxp_simtemp_buffer_pop(struct simtemp_dev *simtemp, u64 *read_seq,
+                              struct simtemp_sample *samples, size_t max)
+{
+	struct simtemp_ring_hdr *ring = simtemp->ring;
+	u64 head, seq, lost;
+	u32 index;
+	size_t n;
+
+retry:
+	head = smp_load_acquire(&ring->producer);
+	seq = READ_ONCE(*read_seq);
+	if ((s64)(head - seq) <= 0) {
+		/* Up to date, or cursor corrupted from userspace: resync */
+		WRITE_ONCE(*read_seq, head);
+		return 0;
+	}
+
+	if (head - seq > ring->capacity) {
+		/* Reader was lapped by the producer: skip to the oldest stored sample */
+		lost = head - seq - ring->capacity;
+		simtemp_stat_add(simtemp, dropped, lost);
+		seq += lost;
+	}
+
+	n = min_t(u64, head - seq, max);
+	div_u64_rem(seq, ring->slots, &index);
+	circular_buf_read_at(&simtemp->samples, index, samples, n);
+
+	smp_rmb(); /* Finish the copy before rechecking producer */
+	head = READ_ONCE(ring->producer);
+	if (head - seq > ring->capacity) {
+		/* Leading records were overwritten while copying and may be torn */
+		lost = min_t(u64, head - seq - ring->capacity, n);
+		simtemp_stat_add(simtemp, dropped, lost);
+		seq += lost;
+		n -= lost;
+		if (!n) {
+			WRITE_ONCE(*read_seq, seq);
+			goto retry;
+		}
+		memmove(samples, samples + lost, n * sizeof(*samples));
+	}
+
+	WRITE_ONCE(*read_seq, seq + n);
+	return n;
+}
+
+/**
+ * @brief Checks whether a reader has unread samples.
+ * Intended for use as the condition in wait_event_* macros and poll.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param read_seq Reader cursor.
+ * @return true if at least one sample is pending for this reader.
+ */
+bool nxp_simtemp_buffer_has_data(struct simtemp_dev *simtemp, u64 read_seq)
+{
+	return (s64)(nxp_simtemp_buffer_head(simtemp) - read_seq) > 0;
+}
+
+/**
+ * @brief Counts the samples pending for a reader.
+ * Lock-free; a reader that was lapped counts the full ring capacity.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param read_seq Reader cursor.
+ * @param oldest_ns If not NULL and samples are pending, receives the
+ *                  timestamp of the oldest pending sample.
+ * @return Number of pending samples (0 if the reader is up to date).
+ */
+u64 nxp_simtemp_buffer_pending(struct simtemp_dev *simtemp, u64 read_seq, u64 *oldest_ns)
+{
+	struct simtemp_ring_hdr *ring = simtemp->ring;
+	struct simtemp_sample sample;
+	u64 head = nxp_simtemp_buffer_head(simtemp);
+	u32 index;
+
+	if ((s64)(head - read_seq) <= 0)
+		return 0;
+	if (head - read_seq > ring->capacity)
+		read_seq = head - ring->capacity; /* Next pop skips to the oldest stored sample */
+
+	if (oldest_ns) {
+		div_u64_rem(read_seq, ring->slots, &index);
+		circular_buf_read_at(&simtemp->samples, index, &sample, 1);
+		*oldest_ns = sample.timestamp_ns;
+	}
+	return head - read_seq;
+}
+
+/**
+ * @brief Returns the sequence number of the next sample to be produced.
+ * New readers start here so they only see samples generated after open().
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return Current head sequence number.
+ */
+u64 nxp_simtemp_buffer_head(struct simtemp_dev *simtemp)
+{
+	return smp_load_acquire(&simtemp->ring->producer);
+}
+
+/**
+ * @brief Finds the first stored sample newer than a timestamp.
+ *
+ * Binary search over the stored samples, which are ordered by timestamp.
+ * The probes are not validated: near the overwrite edge the result may be
+ * too early, so callers must still skip popped samples that are not newer
+ * than @since_ns.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param since_ns Timestamp in nanoseconds (0 selects the oldest stored sample).
+ * @return Sequence number to pop from (the head if no sample is newer).
+ */
+u64 nxp_simtemp_buffer_seek(struct simtemp_dev *simtemp, u64 since_ns)
+{
+	struct simtemp_ring_hdr *ring = simtemp->ring;
+	struct simtemp_sample sample;
+	u64 head, lo, hi, mid;
+	u32 index;
+
+	head = smp_load_acquire(&ring->producer);
+	lo = head - min_t(u64, head, ring->capacity);
+	hi = head;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		div_u64_rem(mid, ring->slots, &index);
+		circular_buf_read_at(&simtemp->samples, index, &sample, 1);
+		if (sample.timestamp_ns > since_ns)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/**
+ * @brief Maps the sample ring read-only into a userspace VMA.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param vma VMA requested with offset SIMTEMP_MMAP_OFF_RING.
+ * @return int 0 on success, or a negative error code.
+ */
+int nxp_simtemp_buffer_mmap(struct simtemp_dev *simtemp, struct vm_area_struct *vma)
+{
+	if (vma->vm_end - vma->vm_start > simtemp->ring_size)
+		return -EINVAL;
+
+	/* Only the producer writes the ring */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vm_flags_clear(vma, VM_MAYWRITE);
+
+	return remap_vmalloc_range(vma, simtemp->ring, 0);
+}
+
+/* Allocates the ring area; vmalloc takes its pages from the node of the running CPU */
+static long simtemp_ring_alloc(void *arg)
+{
+	struct simtemp_dev *simtemp = arg;
+
+	simtemp->ring = vmalloc_user(simtemp->ring_size); /* Zeroed */
+	return simtemp->ring ? 0 : -ENOMEM;
+}
+
+/**
+ * @brief Initializes the sample FIFO.
+ *
+ * Allocates the mmap()able ring: one header page followed by at least
+ * simtemp->depth + 1 record slots, rounded up to whole pages (the capacity
+ * reported in the ring header may therefore exceed the requested depth).
+ * vmalloc_user() takes no node, so for an instance with a sampling CPU the
+ * allocation runs on that CPU, which places the pages on its node. Changing
+ * the CPU later moves the timer, not the ring.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or -ENOMEM.
+ */
+int nxp_simtemp_buffer_init(struct simtemp_dev *simtemp)
+{
+	size_t data_size, slots;
+
+	/* CircularBuffer.h keeps one slot free to tell full from empty */
+	data_size = PAGE_ALIGN(((size_t)simtemp->depth + 1) * sizeof(struct simtemp_sample));
+	slots = data_size / sizeof(struct simtemp_sample);
+
+	simtemp->ring_size = SIMTEMP_RING_HDR_SIZE + data_size;
+	/* -ENODEV: the CPU is offline, take local pages rather than fail the probe */
+	if (simtemp->cpu < 0 || work_on_cpu_safe(simtemp->cpu, simtemp_ring_alloc, simtemp) == -ENODEV)
+		simtemp_ring_alloc(simtemp);
+	if (!simtemp->ring)
+		return -ENOMEM;
+
+	simtemp->ring->magic = SIMTEMP_RING_MAGIC;
+	simtemp->ring->version = SIMTEMP_RING_VERSION;
+	simtemp->ring->record_size = sizeof(struct simtemp_sample);
+	simtemp->ring->slots = slots;
+	simtemp->ring->capacity = slots - 1;
+	simtemp->ring->data_offset = SIMTEMP_RING_HDR_SIZE;
+	simtemp->ring->producer = 0;
+
+	circular_buf_init(&simtemp->samples, (u8 *)simtemp->ring + SIMTEMP_RING_HDR_SIZE,
+	                  slots - 1, sizeof(struct simtemp_sample));
+
+	debug_dbg("Sample buffer initialized (%zu samples)\n", slots - 1);
+	return 0;
+}
+
+/**
+ * @brief Deinitializes the sample FIFO.
+ * Pages still mapped by userspace stay alive until they are unmapped.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_buffer_exit(struct simtemp_dev *simtemp)
+{
+	vfree(simtemp->ring);
+	simtemp->ring = NULL;
+}
@@ -18,10 +18,54 @@
 #define SIMTEMP_SAMPLING_MS_MAX     60000   /* Maximum allowed sampling period (ms) */
 #define SIMTEMP_SAMPLING_MS_DEFAULT 1000    /* Default sampling period (ms) */
 
+/* --- Sampling Period Configuration (microseconds, sampling_us attribute) --- */
+#define SIMTEMP_SAMPLING_US_MIN     100     /* Minimum allowed sampling period (us), 10 kHz */
+#define SIMTEMP_SAMPLING_US_MAX     (SIMTEMP_SAMPLING_MS_MAX * 1000) /* Maximum allowed sampling period (us) */
+
+/* --- Fast replay (speed attribute) --- */
+#define SIMTEMP_SPEED_MIN           1       /* Real time */
+#define SIMTEMP_SPEED_MAX           1000000 /* Virtual clock runs 1000000x faster than CLOCK_MONOTONIC */
+
+/* --- Bulk generation --- */
+/* Shortest timer period: faster sampling generates a block of samples per tick */
+#define SIMTEMP_TICK_US_MIN         1000
+#define SIMTEMP_GEN_BLOCK_MAX       DIV_ROUND_UP(SIMTEMP_TICK_US_MIN, SIMTEMP_SAMPLING_US_MIN)
+
+/* --- Profile mode (sysfs "profile" table) --- */
+#define SIMTEMP_PROFILE_POINTS_MIN  2       /* A table needs at least one segment */
+#define SIMTEMP_PROFILE_POINTS_MAX  4096    /* Largest table accepted */
+
+/* --- Instances (module parameter "instances") --- */
+#define SIMTEMP_INSTANCES_DEFAULT   1       /* Simulated sensors created at module load */
+#define SIMTEMP_INSTANCES_MAX       256     /* Upper bound for the instances parameter */
+#define SIMTEMP_NAME_LEN            16      /* "simtemp" + instance number + NUL */
+
 /* --- Alert Threshold Configuration (milli-degrees Celsius) --- */
 #define SIMTEMP_THRESHOLD_MC_MIN    -50000  /* Minimum allowed threshold (-50.000 C) */
 #define SIMTEMP_THRESHOLD_MC_MAX    150000  /* Maximum allowed threshold (150.000 C) */
 #define SIMTEMP_THRESHOLD_MC_DEFAULT 50000   /* Default threshold (50.000 C) */
+#define SIMTEMP_HYSTERESIS_MC_MAX   100000  /* Widest band below the threshold (100.000 C) */
+
+/* --- Rate-of-change alert (mC per second of sample time, 0 = off) --- */
+#define SIMTEMP_RATE_MC_S_MAX       10000000 /* 10000 C/s */
+
+/* --- Windowed aggregation (agg_window_ms attribute, 0 = off) --- */
+#define SIMTEMP_AGG_WINDOW_MS_MIN   10      /* Shortest window */
+#define SIMTEMP_AGG_WINDOW_MS_MAX   3600000 /* Longest window (1 h) */
+#define SIMTEMP_AGG_DEPTH           64      /* Window records kept per device, power of 2 */
+
+/* --- Sample Buffer Configuration --- */
+#define SIMTEMP_BUFFER_DEPTH        256     /* Samples kept per device before the oldest is overwritten */
+#define SIMTEMP_BUFFER_DEPTH_MIN    16      /* Range of the DT buffer-depth property */
+#define SIMTEMP_BUFFER_DEPTH_MAX    65536
+#define SIMTEMP_READ_BATCH_MAX      SIMTEMP_BUFFER_DEPTH /* Max samples returned by one read() */
+
+/* --- Producer self-benchmark (debugfs bench file) --- */
+#define SIMTEMP_BENCH_ITERATIONS_DEFAULT 100000  /* Ticks per run */
+#define SIMTEMP_BENCH_ITERATIONS_MAX     100000000
+#define SIMTEMP_BENCH_READERS_DEFAULT    1       /* Synthetic readers */
+#define SIMTEMP_BENCH_READERS_MAX        1024
+#define SIMTEMP_BENCH_LOCK_OPS           1000000 /* Operations timed per publication variant */
 
 /* Temperature (mC)*/
 #define SIMTEMP_TEMPERATURE_MC_INITIAL 25000  /* Initial temperature (25.000 C) */
@@ -0,0 +1,251 @@
+/**
+ * @file    nxp_simtemp_debugfs.c
+ * @author  Omar Mendiola
+ * @brief   Debugfs interface of the NXP simtemp driver.
+ * Exposes the latency histograms of every instance as
+ * <debugfs>/nxp_simtemp/simtemp<id>/latency. Reading prints the non-empty
+ * log2 buckets of each histogram; writing anything resets them.
+ * <debugfs>/nxp_simtemp/simtemp<id>/bench runs the producer self-benchmark
+ * (nxp_simtemp_bench.c) on write and prints the last report on read.
+ * @version 0.1
+ * @date    2025-10-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "nxp_simtemp.h"
+
+/* <debugfs>/nxp_simtemp/, parent of the per-instance directories */
+static struct dentry *simtemp_debugfs_root;
+
+static const char * const simtemp_lat_names[SIMTEMP_LAT_MAX] = {
+	[SIMTEMP_LAT_TIMER_JITTER] = "timer_jitter",
+	[SIMTEMP_LAT_WAKE_TO_READ] = "wake_to_read",
+	[SIMTEMP_LAT_END_TO_END]   = "end_to_end",
+};
+
+/**
+ * @brief Prints every histogram of an instance.
+ *
+ * One header line per histogram with its total count, followed by one line
+ * per non-empty bucket: "<low_ns> <high_ns> <count>", high_ns being
+ * exclusive, or "inf" for the last bucket.
+ *
+ * @param m seq_file of the latency file.
+ * @param v Unused.
+ * @return int Always 0.
+ */
+static int simtemp_latency_show(struct seq_file *m, void *v)
+{
+	struct simtemp_dev *simtemp = m->private;
+	u64 buckets[SIMTEMP_LAT_BUCKETS];
+	u64 total;
+	int hist, b;
+
+	for (hist = 0; hist < SIMTEMP_LAT_MAX; hist++) {
+		nxp_simtemp_latency_read(simtemp, hist, buckets);
+
+		for (total = 0, b = 0; b < SIMTEMP_LAT_BUCKETS; b++)
+			total += buckets[b];
+		seq_printf(m, "%s_ns count=%llu\n", simtemp_lat_names[hist], total);
+
+		for (b = 0; b < SIMTEMP_LAT_BUCKETS; b++) {
+			if (!buckets[b])
+				continue;
+			seq_printf(m, "  %llu ", b ? 1ULL << (b - 1) : 0ULL);
+			if (b == SIMTEMP_LAT_BUCKETS - 1)
+				seq_puts(m, "inf");
+			else
+				seq_printf(m, "%llu", 1ULL << b);
+			seq_printf(m, " %llu\n", buckets[b]);
+		}
+	}
+	return 0;
+}
+
+static int simtemp_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, simtemp_latency_show, inode->i_private);
+}
+
+/* Any write resets the histograms, e.g. "echo 0 > latency" */
+static ssize_t simtemp_latency_write(struct file *file, const char __user *buf,
+                                     size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+
+	nxp_simtemp_latency_reset(m->private);
+	return count;
+}
+
+static const struct file_operations simtemp_latency_fops = {
+	.owner   = THIS_MODULE,
+	.open    = simtemp_latency_open,
+	.read    = seq_read,
+	.write   = simtemp_latency_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * @brief Prints the report of the last self-benchmark.
+ * @param m seq_file of the bench file.
+ * @param v Unused.
+ * @return int 0, or -EINTR if interrupted while a run is in progress.
+ */
+static int simtemp_bench_show(struct seq_file *m, void *v)
+{
+	struct simtemp_dev *simtemp = m->private;
+	struct simtemp_bench_result *res = &simtemp->bench;
+	u64 ticks;
+
+	if (mutex_lock_interruptible(&simtemp->bench_lock))
+		return -EINTR;
+	if (!res->iterations) {
+		seq_puts(m, "no run yet, write \"iterations=<n> readers=<n> lowat=<n>\"\n");
+		goto out;
+	}
+
+	ticks = res->iterations;
+	seq_printf(m, "iterations=%u readers=%u lowat=%u samples=%llu\n",
+	           res->iterations, res->readers, res->lowat, res->samples);
+	seq_printf(m, "produce_ns_per_sample=%llu\n", div64_u64(res->produce_ns, max(res->samples, 1ULL)));
+	seq_printf(m, "wake_ns_per_tick=%llu\n", div64_u64(res->wake_ns, ticks));
+	seq_printf(m, "tick_max_ns=%llu\n", res->tick_max_ns);
+	seq_printf(m, "consume_ns_per_wakeup=%llu\n", div64_u64(res->consume_ns, max(res->wakeups, 1ULL)));
+	seq_printf(m, "wakeups=%llu dropped=%llu\n", res->wakeups, res->dropped);
+	seq_printf(m, "lock_uncontended_ns seqcount_write=%llu seqlock_read=%llu spinlock_bh=%llu mutex=%llu\n",
+	           res->lock_uncontended_ns[SIMTEMP_BENCH_SEQCOUNT], res->lock_uncontended_ns[SIMTEMP_BENCH_SEQLOCK_READ],
+	           res->lock_uncontended_ns[SIMTEMP_BENCH_SPINLOCK], res->lock_uncontended_ns[SIMTEMP_BENCH_MUTEX]);
+out:
+	mutex_unlock(&simtemp->bench_lock);
+	return 0;
+}
+
+static int simtemp_bench_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, simtemp_bench_show, inode->i_private);
+}
+
+/**
+ * @brief Runs a self-benchmark, e.g. "echo iterations=100000 readers=4 > bench".
+ * Accepts any subset of iterations, readers and lowat; the others take
+ * their defaults. Returns once the run completed.
+ */
+static ssize_t simtemp_bench_write(struct file *file, const char __user *buf,
+                                   size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct simtemp_dev *simtemp = m->private;
+	u32 iterations = SIMTEMP_BENCH_ITERATIONS_DEFAULT;
+	u32 readers = SIMTEMP_BENCH_READERS_DEFAULT;
+	u32 lowat = 1, *field;
+	char *args, *cur, *tok, *val;
+	int ret = 0;
+
+	args = memdup_user_nul(buf, min_t(size_t, count, PAGE_SIZE - 1));
+	if (IS_ERR(args))
+		return PTR_ERR(args);
+
+	cur = args;
+	while ((tok = strsep(&cur, " \t\n")) != NULL) {
+		if (!*tok)
+			continue;
+		val = strchr(tok, '=');
+		if (!val) {
+			ret = -EINVAL;
+			break;
+		}
+		*val++ = '\0';
+		if (!strcmp(tok, "iterations"))
+			field = &iterations;
+		else if (!strcmp(tok, "readers"))
+			field = &readers;
+		else if (!strcmp(tok, "lowat"))
+			field = &lowat;
+		else {
+			ret = -EINVAL;
+			break;
+		}
+		ret = kstrtou32(val, 0, field);
+		if (ret)
+			break;
+	}
+	kfree(args);
+	if (ret)
+		return ret;
+	if (!iterations || iterations > SIMTEMP_BENCH_ITERATIONS_MAX ||
+	    readers > SIMTEMP_BENCH_READERS_MAX || !lowat || lowat > simtemp->ring->capacity)
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&simtemp->bench_lock))
+		return -EINTR;
+	ret = nxp_simtemp_bench_run(simtemp, iterations, readers, lowat, &simtemp->bench);
+	if (ret)
+		simtemp->bench.iterations = 0; /* No partial report */
+	mutex_unlock(&simtemp->bench_lock);
+	return ret ? ret : count;
+}
+
+static const struct file_operations simtemp_bench_fops = {
+	.owner   = THIS_MODULE,
+	.open    = simtemp_bench_open,
+	.read    = seq_read,
+	.write   = simtemp_bench_write,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * @brief Creates the debugfs directory of an instance.
+ * Debugfs is optional: failures are not reported, per debugfs convention.
+ * Called after the misc device is registered, which names the instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_debugfs_init(struct simtemp_dev *simtemp)
+{
+	mutex_init(&simtemp->bench_lock);
+	simtemp->debugfs_dir = debugfs_create_dir(simtemp->name, simtemp_debugfs_root);
+	debugfs_create_file("latency", 0600, simtemp->debugfs_dir, simtemp,
+	                    &simtemp_latency_fops);
+	debugfs_create_file("bench", 0600, simtemp->debugfs_dir, simtemp,
+	                    &simtemp_bench_fops);
+}
+
+/**
+ * @brief Removes the debugfs directory of an instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_debugfs_exit(struct simtemp_dev *simtemp)
+{
+	/* Waits for a running self-benchmark */
+	debugfs_remove_recursive(simtemp->debugfs_dir);
+	simtemp->debugfs_dir = NULL;
+	mutex_destroy(&simtemp->bench_lock);
+}
+
+/**
+ * @brief Creates the driver-wide debugfs directory, before any probe.
+ */
+void nxp_simtemp_debugfs_register(void)
+{
+	simtemp_debugfs_root = debugfs_create_dir("nxp_simtemp", NULL);
+}
+
+/**
+ * @brief Removes the driver-wide debugfs directory, after the last remove.
+ */
+void nxp_simtemp_debugfs_unregister(void)
+{
+	debugfs_remove_recursive(simtemp_debugfs_root);
+	simtemp_debugfs_root = NULL;
+}
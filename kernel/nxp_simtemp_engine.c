@@ -0,0 +1,278 @@
+/**
+ * @file    nxp_simtemp_engine.c
+ * @author  Omar Mendiola
+ * @brief   Grouped sampling engine shared by all simtemp instances.
+ * Enabled with the "grouped" module parameter. Instances with the same
+ * sampling period join one group; a single hrtimer per group generates the
+ * samples of every member in one pass over a contiguous, cache-aligned
+ * array of generator states and then wakes the readers in a second pass.
+ * CPU cost per tick therefore grows with the number of sensors, not with
+ * the number of timers. Groups are per sampling CPU as well: the timer of a
+ * pinned group fires on its CPU and the member array lives on its node.
+ * @version 0.1
+ * @date    2025-10-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include "nxp_simtemp.h"
+
+/* Initial member array size; doubled when full */
+#define SIMTEMP_GROUP_MIN_SIZE  8
+
+/**
+ * @brief Instances sampled by one shared timer.
+ */
+struct simtemp_group {
+	struct list_head node;      /* Entry in simtemp_groups */
+	u32 period_us;              /* Sampling period of every member */
+	int cpu;                    /* Sampling CPU of every member, -1 = unbound */
+	struct hrtimer timer;       /* Shared sampling timer (softirq, absolute expiries) */
+	spinlock_t lock;            /* Protects gens/count against the tick */
+	struct simtemp_gen *gens;   /* Contiguous generator states of the members */
+	unsigned int count;         /* Members in gens */
+	unsigned int size;          /* Allocated entries in gens */
+};
+
+/* All groups; membership changes are serialized by simtemp_groups_lock */
+static LIST_HEAD(simtemp_groups);
+static DEFINE_MUTEX(simtemp_groups_lock);
+
+/**
+ * @brief Timer period of a group: one generated block per tick.
+ * @param group Sampling group.
+ * @return Tick period in microseconds.
+ */
+static u32 simtemp_group_tick_us(const struct simtemp_group *group)
+{
+	return group->period_us * nxp_simtemp_gen_block(group->period_us);
+}
+
+/**
+ * @brief Timer callback of a group.
+ *
+ * Generates one block of samples per member with a common timestamp, then
+ * wakes the readers once every sample of the tick is visible.
+ *
+ * @param t Pointer to the hrtimer structure.
+ * @return HRTIMER_RESTART, the timer is re-armed one period after its last expiry.
+ */
+static enum hrtimer_restart simtemp_group_callback(struct hrtimer *t)
+{
+	struct simtemp_group *group = container_of(t, struct simtemp_group, timer);
+	ktime_t now = ktime_get();
+	s64 jitter_ns = ktime_to_ns(ktime_sub(now, hrtimer_get_expires(t)));
+	unsigned int i;
+
+	spin_lock(&group->lock);
+	for (i = 0; i < group->count; i++) {
+		nxp_simtemp_latency_record(group->gens[i].simtemp, SIMTEMP_LAT_TIMER_JITTER, jitter_ns);
+		nxp_simtemp_generate(&group->gens[i], ktime_to_ns(now));
+	}
+
+	/* One batched wake-up pass per tick */
+	for (i = 0; i < group->count; i++)
+		nxp_simtemp_wake_readers(group->gens[i].simtemp);
+	spin_unlock(&group->lock);
+
+	hrtimer_forward_now(t, us_to_ktime(simtemp_group_tick_us(group)));
+	return HRTIMER_RESTART;
+}
+
+/**
+ * @brief Finds the group of a period and CPU, creating it if needed.
+ * Called with simtemp_groups_lock held.
+ * @param period_us Sampling period in microseconds.
+ * @param cpu Sampling CPU, or -1 for unbound.
+ * @return The group, or NULL on allocation failure.
+ */
+static struct simtemp_group *simtemp_group_get(u32 period_us, int cpu)
+{
+	struct simtemp_group *group;
+
+	list_for_each_entry(group, &simtemp_groups, node)
+		if (group->period_us == period_us && group->cpu == cpu)
+			return group;
+
+	group = kzalloc_node(sizeof(*group), GFP_KERNEL, nxp_simtemp_cpu_node(cpu));
+	if (!group)
+		return NULL;
+
+	group->period_us = period_us;
+	group->cpu = cpu;
+	spin_lock_init(&group->lock);
+	hrtimer_init(&group->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+	group->timer.function = simtemp_group_callback;
+	list_add_tail(&group->node, &simtemp_groups);
+
+	debug_dbg("Engine: created group for %u us on CPU %d\n", period_us, cpu);
+	return group;
+}
+
+/**
+ * @brief Destroys a group once its last member left.
+ * Called with simtemp_groups_lock held.
+ * @param group Group to release.
+ */
+static void simtemp_group_put(struct simtemp_group *group)
+{
+	if (group->count)
+		return;
+
+	hrtimer_cancel(&group->timer);
+	list_del(&group->node);
+	kfree(group->gens);
+	kfree(group);
+}
+
+/**
+ * @brief Makes room for one more member, so insertion cannot fail.
+ * Called with simtemp_groups_lock held; may sleep.
+ * @param group Group to grow.
+ * @return int 0 on success, or -ENOMEM.
+ */
+static int simtemp_group_reserve(struct simtemp_group *group)
+{
+	struct simtemp_gen *gens, *old;
+	unsigned int size;
+
+	if (group->count < group->size)
+		return 0;
+
+	size = group->size ? group->size * 2 : SIMTEMP_GROUP_MIN_SIZE;
+	gens = kmalloc_array_node(size, sizeof(*gens), GFP_KERNEL, nxp_simtemp_cpu_node(group->cpu));
+	if (!gens)
+		return -ENOMEM;
+
+	spin_lock_bh(&group->lock);
+	if (group->count)
+		memcpy(gens, group->gens, group->count * sizeof(*gens));
+	old = group->gens;
+	group->gens = gens;
+	group->size = size;
+	spin_unlock_bh(&group->lock);
+
+	kfree(old);
+	return 0;
+}
+
+/**
+ * @brief Adds a generator state to a group with reserved room.
+ * Starts the group timer with its first member.
+ * @param group Destination group.
+ * @param gen Generator state of the joining instance.
+ */
+static void simtemp_group_insert(struct simtemp_group *group, const struct simtemp_gen *gen)
+{
+	bool first;
+
+	spin_lock_bh(&group->lock);
+	first = !group->count;
+	group->gens[group->count++] = *gen;
+	gen->simtemp->group = group;
+	spin_unlock_bh(&group->lock);
+
+	if (first)
+		nxp_simtemp_timer_start(&group->timer,
+		                        ktime_add_us(ktime_get(), simtemp_group_tick_us(group)), group->cpu);
+}
+
+/**
+ * @brief Removes an instance from its group.
+ * The last member is moved into the hole to keep the array dense.
+ * @param group Group the instance belongs to.
+ * @param simtemp Leaving instance.
+ * @param gen Receives the generator state of the instance.
+ */
+static void simtemp_group_remove(struct simtemp_group *group, struct simtemp_dev *simtemp,
+                                 struct simtemp_gen *gen)
+{
+	unsigned int i;
+
+	spin_lock_bh(&group->lock);
+	for (i = 0; i < group->count; i++) {
+		if (group->gens[i].simtemp == simtemp) {
+			*gen = group->gens[i];
+			group->gens[i] = group->gens[--group->count];
+			break;
+		}
+	}
+	simtemp->group = NULL;
+	spin_unlock_bh(&group->lock);
+}
+
+/**
+ * @brief Attaches an instance to the group of a sampling period and CPU.
+ *
+ * Used at start-up and whenever the sampling period or the sampling CPU of
+ * the instance changes.
+ * The generator state moves with the instance, so ramp continuity and
+ * statistics are kept. On failure the instance stays where it was.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param period_us Sampling period in microseconds.
+ * @return int 0 on success, or -ENOMEM.
+ */
+int nxp_simtemp_engine_attach(struct simtemp_dev *simtemp, u32 period_us)
+{
+	struct simtemp_group *group, *old;
+	int cpu = READ_ONCE(simtemp->cpu);
+	struct simtemp_gen gen;
+	int ret = 0;
+
+	mutex_lock(&simtemp_groups_lock);
+	old = simtemp->group;
+	if (old && old->period_us == period_us && old->cpu == cpu)
+		goto out;
+
+	group = simtemp_group_get(period_us, cpu);
+	if (!group) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = simtemp_group_reserve(group);
+	if (ret) {
+		simtemp_group_put(group);
+		goto out;
+	}
+
+	if (old) {
+		simtemp_group_remove(old, simtemp, &gen);
+		simtemp_group_put(old);
+	} else {
+		gen = simtemp->gen;
+	}
+	simtemp_group_insert(group, &gen);
+
+out:
+	mutex_unlock(&simtemp_groups_lock);
+	return ret;
+}
+
+/**
+ * @brief Detaches an instance from its group, stopping its sampling.
+ * The generator state is copied back into the instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_engine_detach(struct simtemp_dev *simtemp)
+{
+	struct simtemp_group *group;
+
+	mutex_lock(&simtemp_groups_lock);
+	group = simtemp->group;
+	if (group) {
+		simtemp_group_remove(group, simtemp, &simtemp->gen);
+		simtemp_group_put(group);
+	}
+	mutex_unlock(&simtemp_groups_lock);
+}
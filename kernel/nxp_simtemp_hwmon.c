@@ -0,0 +1,151 @@
+/**
+ * @file    nxp_simtemp_hwmon.c
+ * @author  Omar Mendiola
+ * @brief   hwmon (and thermal zone) interface of the NXP simtemp driver.
+ * Registers one temperature channel per instance: temp1_input is the latest
+ * sample, temp1_max the alert threshold, temp1_max_hyst the point where the
+ * threshold alert clears and temp1_max_alarm the alert state. The values are
+ * read from the same producer output as the misc device, so lm-sensors and
+ * other hwmon clients need no custom reader. With HWMON_C_REGISTER_TZ the
+ * hwmon core also registers a thermal zone when the DT node of the device
+ * is referenced as a thermal sensor, so thermal governors can act on it.
+ * Compiled out when the kernel has no hwmon support.
+ * @version 0.1
+ * @date    2025-10-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/device.h>
+#include <linux/err.h>
+#include <linux/hwmon.h>
+
+#include "nxp_simtemp.h"
+
+#if SIMTEMP_HAVE_HWMON
+
+static umode_t simtemp_hwmon_is_visible(const void *data, enum hwmon_sensor_types type,
+                                        u32 attr, int channel)
+{
+	switch (attr) {
+	case hwmon_temp_input:
+	case hwmon_temp_max_hyst:
+	case hwmon_temp_max_alarm:
+		return 0444;
+	case hwmon_temp_max:
+		return 0644;
+	default:
+		return 0;
+	}
+}
+
+static int simtemp_hwmon_read(struct device *dev, enum hwmon_sensor_types type,
+                              u32 attr, int channel, long *val)
+{
+	struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_sample sample;
+	struct simtemp_config cfg;
+
+	switch (attr) {
+	case hwmon_temp_input:
+		nxp_simtemp_sample_read(simtemp, &sample);
+		*val = sample.temp_mc;
+		return 0;
+	case hwmon_temp_max_alarm:
+		nxp_simtemp_sample_read(simtemp, &sample);
+		*val = !!(sample.flags & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI);
+		return 0;
+	case hwmon_temp_max:
+		nxp_simtemp_config_read(simtemp, &cfg);
+		*val = cfg.threshold_mc;
+		return 0;
+	case hwmon_temp_max_hyst:
+		nxp_simtemp_config_read(simtemp, &cfg);
+		*val = cfg.threshold_mc - (s32)cfg.hysteresis_mc;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static int simtemp_hwmon_write(struct device *dev, enum hwmon_sensor_types type,
+                               u32 attr, int channel, long val)
+{
+	struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+
+	if (attr != hwmon_temp_max)
+		return -EOPNOTSUPP;
+
+	/* Same limits as the threshold_mc attribute */
+	if (val < SIMTEMP_THRESHOLD_MC_MIN || val > SIMTEMP_THRESHOLD_MC_MAX)
+		return -EINVAL;
+
+	mutex_lock(&simtemp->sched_lock); /* Every cfg writer holds it, see nxp_simtemp_sysfs.c */
+	write_seqlock_bh(&simtemp->cfg_lock);
+	simtemp->cfg.threshold_mc = (s32)val;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+	mutex_unlock(&simtemp->sched_lock);
+	return 0;
+}
+
+static const struct hwmon_ops simtemp_hwmon_ops = {
+	.is_visible = simtemp_hwmon_is_visible,
+	.read = simtemp_hwmon_read,
+	.write = simtemp_hwmon_write,
+};
+
+static const struct hwmon_channel_info * const simtemp_hwmon_info[] = {
+	HWMON_CHANNEL_INFO(chip, HWMON_C_REGISTER_TZ),
+	HWMON_CHANNEL_INFO(temp, HWMON_T_INPUT | HWMON_T_MAX | HWMON_T_MAX_HYST | HWMON_T_MAX_ALARM),
+	NULL
+};
+
+static const struct hwmon_chip_info simtemp_hwmon_chip = {
+	.ops = &simtemp_hwmon_ops,
+	.info = simtemp_hwmon_info,
+};
+
+/**
+ * @brief Registers the hwmon device of an instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or a negative error code.
+ */
+int nxp_simtemp_hwmon_init(struct simtemp_dev *simtemp)
+{
+	struct device *hwmon;
+
+	/* hwmon names may not contain '-', "simtemp" is shared by all instances */
+	hwmon = hwmon_device_register_with_info(simtemp->dev, "simtemp", simtemp,
+	                                        &simtemp_hwmon_chip, NULL);
+	if (IS_ERR(hwmon))
+		return PTR_ERR(hwmon);
+
+	simtemp->hwmon_dev = hwmon;
+	debug_dbg("hwmon device registered\n");
+	return 0;
+}
+
+/**
+ * @brief Unregisters the hwmon device (and its thermal zone).
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_hwmon_exit(struct simtemp_dev *simtemp)
+{
+	if (simtemp->hwmon_dev)
+		hwmon_device_unregister(simtemp->hwmon_dev);
+	simtemp->hwmon_dev = NULL;
+}
+
+#else /* !SIMTEMP_HAVE_HWMON */
+
+int nxp_simtemp_hwmon_init(struct simtemp_dev *simtemp)
+{
+	return 0;
+}
+
+void nxp_simtemp_hwmon_exit(struct simtemp_dev *simtemp)
+{
+}
+
+#endif /* SIMTEMP_HAVE_HWMON */
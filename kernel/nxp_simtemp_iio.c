@@ -0,0 +1,194 @@
+/**
+ * @file    nxp_simtemp_iio.c
+ * @author  Omar Mendiola
+ * @brief   IIO interface of the NXP simtemp driver.
+ * Registers one IIO device per instance with a temperature channel (raw in
+ * milli-Celsius, scale 1) and a timestamp channel, backed by a software
+ * kfifo buffer. While the buffer is enabled the producer pushes every
+ * generated sample into it from the timer (nxp_simtemp_iio_push()), so IIO
+ * clients get their usual batching and watermark handling from the same
+ * sample stream as /dev/simtemp<id>. Timestamps are the sample timestamps
+ * (instance clock, CLOCK_MONOTONIC based), not the IIO device clock.
+ * Compiled out when the kernel has no IIO kfifo buffer support.
+ * @version 0.1
+ * @date    2025-10-31
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/device.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/kfifo_buf.h>
+#include <linux/rcupdate.h>
+
+#include "nxp_simtemp.h"
+
+#if SIMTEMP_HAVE_IIO
+
+/**
+ * @brief One buffered scan: the temperature, then the timestamp the IIO
+ * core writes into the last 8 bytes.
+ */
+struct simtemp_iio_scan {
+	s32 temp_mc;
+	s64 timestamp __aligned(8);
+};
+
+static const struct iio_chan_spec simtemp_iio_channels[] = {
+	{
+		.type = IIO_TEMP,
+		.info_mask_separate = BIT(IIO_CHAN_INFO_RAW) | BIT(IIO_CHAN_INFO_SCALE),
+		.info_mask_shared_by_all = BIT(IIO_CHAN_INFO_SAMP_FREQ),
+		.scan_index = 0,
+		.scan_type = {
+			.sign = 's',
+			.realbits = 32,
+			.storagebits = 32,
+			.endianness = IIO_CPU,
+		},
+	},
+	IIO_CHAN_SOFT_TIMESTAMP(1),
+};
+
+static struct simtemp_dev *simtemp_iio_dev(struct iio_dev *indio_dev)
+{
+	return *(struct simtemp_dev **)iio_priv(indio_dev);
+}
+
+static int simtemp_iio_read_raw(struct iio_dev *indio_dev, struct iio_chan_spec const *chan,
+                                int *val, int *val2, long mask)
+{
+	struct simtemp_dev *simtemp = simtemp_iio_dev(indio_dev);
+	struct simtemp_sample sample;
+	struct simtemp_config cfg;
+
+	switch (mask) {
+	case IIO_CHAN_INFO_RAW:
+		nxp_simtemp_sample_read(simtemp, &sample);
+		*val = sample.temp_mc;
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SCALE:
+		*val = 1; /* IIO temperatures are in milli-Celsius already */
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SAMP_FREQ:
+		/* Rate at which samples reach the buffer, fast replay included */
+		nxp_simtemp_config_read(simtemp, &cfg);
+		*val = USEC_PER_SEC;
+		*val2 = nxp_simtemp_emit_period_us(&cfg);
+		return IIO_VAL_FRACTIONAL;
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct iio_info simtemp_iio_info = {
+	.read_raw = simtemp_iio_read_raw,
+};
+
+/* Buffer enabled: the producer starts pushing on its next tick (lazy mode: starts sampling) */
+static int simtemp_iio_postenable(struct iio_dev *indio_dev)
+{
+	struct simtemp_dev *simtemp = simtemp_iio_dev(indio_dev);
+	int ret;
+
+	ret = nxp_simtemp_simulator_get(simtemp);
+	if (ret)
+		return ret;
+	rcu_assign_pointer(simtemp->iio_active, indio_dev);
+	return 0;
+}
+
+/* Buffer being disabled: no push may be in flight once this returns */
+static int simtemp_iio_predisable(struct iio_dev *indio_dev)
+{
+	struct simtemp_dev *simtemp = simtemp_iio_dev(indio_dev);
+
+	RCU_INIT_POINTER(simtemp->iio_active, NULL);
+	synchronize_rcu();
+	nxp_simtemp_simulator_put(simtemp);
+	return 0;
+}
+
+static const struct iio_buffer_setup_ops simtemp_iio_buffer_ops = {
+	.postenable = simtemp_iio_postenable,
+	.predisable = simtemp_iio_predisable,
+};
+
+/**
+ * @brief Pushes a generated sample into the IIO buffer, if it is enabled.
+ * Called by the producer for every sample; lock-free, softirq context.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param sample Sample just pushed into the sample FIFO.
+ */
+void nxp_simtemp_iio_push(struct simtemp_dev *simtemp, const struct simtemp_sample *sample)
+{
+	struct simtemp_iio_scan scan = { .temp_mc = sample->temp_mc }; /* No stale padding */
+	struct iio_dev *indio_dev;
+
+	rcu_read_lock();
+	indio_dev = rcu_dereference(simtemp->iio_active);
+	if (indio_dev)
+		iio_push_to_buffers_with_timestamp(indio_dev, &scan, sample->timestamp_ns);
+	rcu_read_unlock();
+}
+
+/**
+ * @brief Registers the IIO device of an instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or a negative error code.
+ */
+int nxp_simtemp_iio_init(struct simtemp_dev *simtemp)
+{
+	struct iio_dev *indio_dev;
+	int ret;
+
+	/* Freed by devres after remove(), unregistered in nxp_simtemp_iio_exit() */
+	indio_dev = devm_iio_device_alloc(simtemp->dev, sizeof(simtemp));
+	if (!indio_dev)
+		return -ENOMEM;
+
+	*(struct simtemp_dev **)iio_priv(indio_dev) = simtemp;
+	indio_dev->name = simtemp->name;
+	indio_dev->info = &simtemp_iio_info;
+	indio_dev->modes = INDIO_DIRECT_MODE;
+	indio_dev->channels = simtemp_iio_channels;
+	indio_dev->num_channels = ARRAY_SIZE(simtemp_iio_channels);
+
+	ret = devm_iio_kfifo_buffer_setup(simtemp->dev, indio_dev, &simtemp_iio_buffer_ops);
+	if (ret)
+		return ret;
+
+	ret = iio_device_register(indio_dev);
+	if (ret)
+		return ret;
+
+	simtemp->iio_dev = indio_dev;
+	debug_dbg("IIO device registered\n");
+	return 0;
+}
+
+/**
+ * @brief Unregisters the IIO device; an enabled buffer is disabled first.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_iio_exit(struct simtemp_dev *simtemp)
+{
+	if (simtemp->iio_dev)
+		iio_device_unregister(simtemp->iio_dev);
+	simtemp->iio_dev = NULL;
+}
+
+#else /* !SIMTEMP_HAVE_IIO */
+
+int nxp_simtemp_iio_init(struct simtemp_dev *simtemp)
+{
+	return 0;
+}
+
+void nxp_simtemp_iio_exit(struct simtemp_dev *simtemp)
+{
+}
+
+#endif /* SIMTEMP_HAVE_IIO */
@@ -2,8 +2,16 @@
  * @file      nxp_simtemp_locks.c
  * @author    Omar Mendiola
  * @brief     Locks implementation for the NXP simtemp driver.
- * @version   0.1
- * @date      2025-10-17
+ * The producer runs in timer (softirq) context and must never sleep or
+ * wait for readers, so shared state is published with sequence counters:
+ *  - cfg_lock (seqlock): sysfs writers take it with BHs disabled, the
+ *    producer reads a consistent struct simtemp_config and retries if a
+ *    write raced with it.
+ *  - sample_seq (seqcount): the producer is the only writer of
+ *    latest_sample; poll readers retry instead of blocking it.
+ * Statistics need no lock at all, see nxp_simtemp_stats.c.
+ * @version   0.2
+ * @date      2025-10-23
  * 
  * @copyright Copyright (c) 2025
  * 
@@ -23,10 +31,60 @@
 /* Functions -----------------------------------------------------------------*/
 void nxp_simtemp_locks_init(struct simtemp_dev *simtemp)
 {
-    mutex_init(&simtemp->lock);
+    seqlock_init(&simtemp->cfg_lock);
+    seqcount_init(&simtemp->sample_seq);
+    mutex_init(&simtemp->sched_lock);
+    mutex_init(&simtemp->run_lock);
 }
 
 void nxp_simtemp_locks_exit(struct simtemp_dev *simtemp)
 {
-    mutex_destroy(&simtemp->lock);
+    /* Sequence counters hold no resources */
+    mutex_destroy(&simtemp->run_lock);
+    mutex_destroy(&simtemp->sched_lock);
+}
+
+/**
+ * @brief Takes a consistent snapshot of the runtime configuration.
+ * Lock-free for the caller: retries while a sysfs write is in progress.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param cfg Destination for the snapshot.
+ */
+void nxp_simtemp_config_read(struct simtemp_dev *simtemp, struct simtemp_config *cfg)
+{
+    unsigned int seq;
+
+    do {
+        seq = read_seqbegin(&simtemp->cfg_lock);
+        *cfg = simtemp->cfg;
+    } while (read_seqretry(&simtemp->cfg_lock, seq));
+}
+
+/**
+ * @brief Reads the latest sample published by the producer.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param latest Destination for the latest sample.
+ */
+void nxp_simtemp_sample_read(struct simtemp_dev *simtemp, struct simtemp_sample *latest)
+{
+    unsigned int seq;
+
+    do {
+        seq = read_seqcount_begin(&simtemp->sample_seq);
+        *latest = simtemp->latest_sample;
+    } while (read_seqcount_retry(&simtemp->sample_seq, seq));
+}
+
+/**
+ * @brief Publishes a new latest sample.
+ * Must only be called by the producer (timer callback), which is the single
+ * writer and already runs with preemption disabled.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param latest New latest sample.
+ */
+void nxp_simtemp_sample_publish(struct simtemp_dev *simtemp, const struct simtemp_sample *latest)
+{
+    write_seqcount_begin(&simtemp->sample_seq);
+    simtemp->latest_sample = *latest;
+    write_seqcount_end(&simtemp->sample_seq);
 }
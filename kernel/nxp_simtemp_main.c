@@ -3,7 +3,11 @@
  * @author  Omar Mendiola
  * @brief   Main file for the NXP simulated temperature sensor driver.
  * This file handles the platform driver registration, probe/remove
- * logic, and module initialization/exit.
+ * logic, and module initialization/exit. The "instances" module parameter
+ * creates N platform devices; every probed device (platform or DT) gets its
+ * own struct simtemp_dev and an instance number: its platform device id or
+ * DT "simtemp" alias, else a free one from simtemp_ida. Probes run
+ * asynchronously, so the number never depends on probe order.
  * @version 0.1
  * @date    2025-10-14
  *
@@ -16,6 +20,12 @@
 #include <linux/of.h>
 #include <linux/delay.h>
 #include <linux/property.h>
+#include <linux/idr.h>
+#include <linux/slab.h>
+#include <linux/stringify.h>
+#include <linux/cpumask.h>
+#include <linux/string.h>
+#include <linux/rcupdate.h>
 
 #include "nxp_simtemp.h"
 
@@ -28,57 +38,165 @@ extern int nxp_simtemp_sysfs_init(struct simtemp_dev *simtemp);
 extern void nxp_simtemp_sysfs_exit(struct simtemp_dev *simtemp);
 extern void nxp_simtemp_locks_init(struct simtemp_dev *simtemp);
 extern void nxp_simtemp_locks_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_stats_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_stats_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_buffer_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_buffer_exit(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_debugfs_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_debugfs_exit(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_profile_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_profile_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_agg_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_agg_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_hwmon_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_hwmon_exit(struct simtemp_dev *simtemp);
+extern int nxp_simtemp_iio_init(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_iio_exit(struct simtemp_dev *simtemp);
+extern void nxp_simtemp_debugfs_register(void);
+extern void nxp_simtemp_debugfs_unregister(void);
+
+static unsigned int instances = SIMTEMP_INSTANCES_DEFAULT;
+module_param(instances, uint, 0444);
+MODULE_PARM_DESC(instances, "Number of simulated sensors to create (1-"
+                 __stringify(SIMTEMP_INSTANCES_MAX) ")");
+
+#if SIMTEMP_DEBUG == SIMTEMP_DEBUG_ENABLED
+/* Runtime switch of the debug messages, only present in SIMTEMP_DEBUG=1 builds */
+bool simtemp_debug = true;
+module_param_named(debug, simtemp_debug, bool, 0644);
+MODULE_PARM_DESC(debug, "Print debug messages (debug builds only)");
+#endif
+
+/* Instance numbers, shared by module-created and DT-created devices */
+static DEFINE_IDA(simtemp_ida);
 
 /**
- * @brief Reads configuration properties from the Device Tree node.
+ * @brief Reads an optional u32 property within [min, max].
+ * @param dev Pointer to the device structure.
+ * @param name Property name.
+ * @param min Lowest accepted value.
+ * @param max Highest accepted value.
+ * @param def Value used when the property is absent or out of range.
+ * @return The property value, or @def.
+ */
+static u32 nxp_simtemp_dt_u32(struct device *dev, const char *name, u32 min, u32 max, u32 def)
+{
+	u32 val;
+
+	if (device_property_read_u32(dev, name, &val))
+		return def;
+	if (val < min || val > max) {
+		dev_warn(dev, "DT: '%s' value %u out of range [%u-%u], using default %u\n",
+		         name, val, min, max, def);
+		return def;
+	}
+	dev_dbg(dev, "DT: '%s' set to %u\n", name, val);
+	return val;
+}
+
+/**
+ * @brief Reads the configuration of the instance from its Device Tree node.
  *
- * Reads "sampling-ms" and "threshold-mC". If properties are not found
- * or invalid, default values from simtemp_config.h are used.
+ * One pass over the node of the device (each "nxp,simtemp" node is its own
+ * platform device): "sampling-ms", "threshold-mC", "hysteresis-mC", "mode",
+ * "buffer-depth", "watermark" and "cpu". Absent or invalid properties take
+ * the defaults from nxp_simtemp_config.h, so module-created devices (no
+ * node) get the defaults too; without "cpu" the instance is not bound to a
+ * CPU. Only invalid values are logged at info level or above, so hundreds
+ * of nodes do not flood the console at boot.
  *
  * @param dev Pointer to the device structure.
  * @param simtemp Pointer to the driver's instance data structure.
  */
 static void nxp_simtemp_read_dt_config(struct device *dev, struct simtemp_dev *simtemp)
 {
-	int ret;
+	const char *mode;
 	u32 val_u32;
+	s32 val_s32;
+	int ret;
 
-	/* Read sampling-ms */
-	ret = device_property_read_u32(dev, "sampling-ms", &val_u32);
-	if (ret) {
-		dev_info(dev, "DT: 'sampling-ms' not found, using default %u ms\n",
-		         SIMTEMP_SAMPLING_MS_DEFAULT);
-		simtemp->sampling_ms = SIMTEMP_SAMPLING_MS_DEFAULT;
-	} else {
-		/* Validate the value read from DT */
-		if (val_u32 < SIMTEMP_SAMPLING_MS_MIN || val_u32 > SIMTEMP_SAMPLING_MS_MAX) {
-			dev_warn(dev, "DT: 'sampling-ms' value %u out of range [%u-%u], using default %u ms\n",
-			         val_u32, SIMTEMP_SAMPLING_MS_MIN, SIMTEMP_SAMPLING_MS_MAX, SIMTEMP_SAMPLING_MS_DEFAULT);
-			simtemp->sampling_ms = SIMTEMP_SAMPLING_MS_DEFAULT;
-		} else {
-			simtemp->sampling_ms = val_u32;
-			dev_info(dev, "DT: 'sampling-ms' set to %u ms\n", simtemp->sampling_ms);
-		}
+	simtemp->cfg.sampling_us = nxp_simtemp_dt_u32(dev, "sampling-ms", SIMTEMP_SAMPLING_MS_MIN,
+	                                              SIMTEMP_SAMPLING_MS_MAX,
+	                                              SIMTEMP_SAMPLING_MS_DEFAULT) * USEC_PER_MSEC;
+	simtemp->cfg.hysteresis_mc = nxp_simtemp_dt_u32(dev, "hysteresis-mC", 0,
+	                                                SIMTEMP_HYSTERESIS_MC_MAX, 0);
+	simtemp->depth = nxp_simtemp_dt_u32(dev, "buffer-depth", SIMTEMP_BUFFER_DEPTH_MIN,
+	                                    SIMTEMP_BUFFER_DEPTH_MAX, SIMTEMP_BUFFER_DEPTH);
+	/* The ring capacity rounds up to whole pages, so the depth is a safe bound */
+	simtemp->lowat = nxp_simtemp_dt_u32(dev, "watermark", 1, simtemp->depth, 1);
+
+	/* Read threshold-mC: cells are u32, a negative value is <(-5000)> (two's complement) */
+	simtemp->cfg.threshold_mc = SIMTEMP_THRESHOLD_MC_DEFAULT;
+	if (!device_property_read_u32(dev, "threshold-mC", &val_u32)) {
+		val_s32 = (s32)val_u32;
+		if (val_s32 < SIMTEMP_THRESHOLD_MC_MIN || val_s32 > SIMTEMP_THRESHOLD_MC_MAX)
+			dev_warn(dev, "DT: 'threshold-mC' value %d out of range [%d-%d], using default %d mC\n",
+			         val_s32, SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX,
+			         SIMTEMP_THRESHOLD_MC_DEFAULT);
+		else
+			simtemp->cfg.threshold_mc = val_s32;
 	}
 
-	/* Read threshold-mC (signed value) */
-	ret = device_property_read_u32(dev, "threshold-mC", &val_u32);
-	if (ret) {
-		dev_info(dev, "DT: 'threshold-mC' not found, using default %d mC\n",
-		         SIMTEMP_THRESHOLD_MC_DEFAULT);
-		simtemp->threshold_mc = SIMTEMP_THRESHOLD_MC_DEFAULT;
-	} else {
-		/* Validate the value read from DT */
-		if (val_u32 < SIMTEMP_THRESHOLD_MC_MIN || val_u32 > SIMTEMP_THRESHOLD_MC_MAX) {
-			dev_warn(dev, "DT: 'threshold-mC' value %d out of range [%d-%d], using default %d mC\n",
-			         val_u32, SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX, SIMTEMP_THRESHOLD_MC_DEFAULT);
-			simtemp->threshold_mc = SIMTEMP_THRESHOLD_MC_DEFAULT;
-		} else {
-			simtemp->threshold_mc = val_u32;
-			dev_info(dev, "DT: 'threshold-mC' set to %d mC\n", simtemp->threshold_mc);
-		}
+	/* Read mode: "normal", "noisy" or "ramp" (profile needs a table, uploaded at run time) */
+	simtemp->cfg.mode = SIMTEMP_MODE_NORMAL;
+	if (!device_property_read_string(dev, "mode", &mode)) {
+		ret = match_string(nxp_simtemp_modes, SIMTEMP_MODE_MAX, mode);
+		if (ret < 0 || ret == SIMTEMP_MODE_PROFILE)
+			dev_warn(dev, "DT: 'mode' \"%s\" not supported, using normal\n", mode);
+		else
+			simtemp->cfg.mode = ret;
+	}
+
+	/* Read cpu: sampling CPU, its node also backs the sample buffers */
+	simtemp->cpu = -1;
+	if (!device_property_read_u32(dev, "cpu", &val_u32)) {
+		if (val_u32 >= nr_cpu_ids || !cpu_possible(val_u32))
+			dev_warn(dev, "DT: 'cpu' %u is not a possible CPU, sampling unbound\n", val_u32);
+		else
+			simtemp->cpu = val_u32;
+	}
+
+	dev_dbg(dev, "DT: sampling %u us, threshold %d mC, mode %s, depth %u, watermark %u, cpu %d\n",
+	        simtemp->cfg.sampling_us, simtemp->cfg.threshold_mc,
+	        nxp_simtemp_modes[simtemp->cfg.mode], simtemp->depth, simtemp->lowat, simtemp->cpu);
+}
+
+/**
+ * @brief Allocates the instance number of a device.
+ *
+ * The number names /dev/simtemp<N>, so it must not depend on the order in
+ * which the asynchronous probes finish. Module-created devices take their
+ * platform device id, DT nodes their "simtemp" alias (aliases { simtemp3 =
+ * &node; };). Devices without either, or whose number is already taken,
+ * get the first free number above both ranges from simtemp_ida.
+ *
+ * @param pdev Pointer to the platform_device structure.
+ * @return int The instance number, or a negative error code.
+ */
+static int nxp_simtemp_alloc_id(struct platform_device *pdev)
+{
+	int id = -1, first, ret;
+
+	if (pdev->id >= 0 && !pdev->id_auto)
+		id = pdev->id;
+	else if (pdev->dev.of_node)
+		id = of_alias_get_id(pdev->dev.of_node, "simtemp");
+
+	if (id >= 0 && id < SIMTEMP_INSTANCES_MAX) {
+		ret = ida_alloc_range(&simtemp_ida, id, id, GFP_KERNEL);
+		if (ret != -ENOSPC)
+			return ret;
+		dev_warn(&pdev->dev, "Instance number %d already taken\n", id);
 	}
-    /* Add reads for other properties like 'mode' if needed */
+
+	/* Keep the module-created and aliased numbers free for their devices */
+	first = max_t(int, instances, of_alias_get_highest_id("simtemp") + 1);
+	if (first < SIMTEMP_INSTANCES_MAX) {
+		ret = ida_alloc_range(&simtemp_ida, first, SIMTEMP_INSTANCES_MAX - 1, GFP_KERNEL);
+		if (ret != -ENOSPC)
+			return ret;
+	}
+	return ida_alloc_max(&simtemp_ida, SIMTEMP_INSTANCES_MAX - 1, GFP_KERNEL);
 }
 
 /**
@@ -110,17 +228,49 @@ struct device *dev = &pdev->dev;
     simtemp->dev = dev;
     platform_set_drvdata(pdev, simtemp);
 
+    ret = nxp_simtemp_alloc_id(pdev);
+    if (ret < 0) {
+        dev_err(dev, "No free instance number\n");
+        return ret;
+    }
+    simtemp->id = ret;
+    ret = 0;
+
     /* Read Device Tree configuration FIRST */
 	nxp_simtemp_read_dt_config(dev, simtemp);
 
-    /*Initialize simtemp locks (mutex)*/
+    /*Initialize simtemp locks (seqlock/seqcount)*/
     nxp_simtemp_locks_init(simtemp);
 
+    /* Profile mode starts without a table */
+    nxp_simtemp_profile_init(simtemp);
+
+    /* Per-CPU statistics, used by the producer and the readers */
+    ret = nxp_simtemp_stats_init(simtemp);
+    if (ret) {
+        dev_err(dev, "Failed to allocate statistics\n");
+        goto err_cleanup;
+    }
+
+    /* Initialize the sample FIFO before readers can open the device */
+    ret = nxp_simtemp_buffer_init(simtemp);
+    if (ret) {
+        dev_err(dev, "Failed to initialize sample buffer\n");
+        goto err_stats;
+    }
+
+    /* Window records of the aggregated read() format */
+    ret = nxp_simtemp_agg_init(simtemp);
+    if (ret) {
+        dev_err(dev, "Failed to initialize aggregation ring\n");
+        goto err_buffer;
+    }
+
     /*Initialize misc device, which now populates simtemp->misc_dev */
     ret = nxp_simtemp_miscdev_init(simtemp);
     if (ret) {
         dev_err(dev, "Failed to initialize misc device\n");
-        goto err_cleanup;
+        goto err_agg;
     }
 
     /* Initialize sysfs using the misc device's device struct */
@@ -130,11 +280,27 @@ struct device *dev = &pdev->dev;
         goto err_miscdev;
     }
 
+    /* hwmon (and thermal zone) and IIO views of the same producer */
+    ret = nxp_simtemp_hwmon_init(simtemp);
+    if (ret) {
+        dev_err(dev, "Failed to register hwmon device\n");
+        goto err_sysfs;
+    }
+
+    ret = nxp_simtemp_iio_init(simtemp);
+    if (ret) {
+        dev_err(dev, "Failed to register IIO device\n");
+        goto err_hwmon;
+    }
+
+    /* Latency histograms in debugfs (optional, cannot fail) */
+    nxp_simtemp_debugfs_init(simtemp);
+
     /* Initialize the temperature simulator (timer)*/
    ret = nxp_simtemp_simulator_init(simtemp);
     if (ret) {
         dev_err(dev, "Failed to initialize simulator\n");
-        goto err_sysfs;
+        goto err_debugfs;
     }
 
     dev_info(dev, "Device successfully probed\n");
@@ -143,12 +309,25 @@ struct device *dev = &pdev->dev;
     /*Action error section*/
 //err_simulator: Not necessary for now
 //    nxp_simtemp_simulator_exit(simtemp);
+err_debugfs:
+    nxp_simtemp_debugfs_exit(simtemp);
+    nxp_simtemp_iio_exit(simtemp);
+err_hwmon:
+    nxp_simtemp_hwmon_exit(simtemp);
 err_sysfs:
     nxp_simtemp_sysfs_exit(simtemp);
 err_miscdev:
     nxp_simtemp_miscdev_exit(simtemp);
+err_agg:
+    nxp_simtemp_agg_exit(simtemp);
+err_buffer:
+    nxp_simtemp_buffer_exit(simtemp);
+err_stats:
+    nxp_simtemp_stats_exit(simtemp);
 err_cleanup:
+    nxp_simtemp_profile_exit(simtemp);
     nxp_simtemp_locks_exit(simtemp);
+    ida_free(&simtemp_ida, simtemp->id);
 
     return ret;
 }
@@ -168,18 +347,44 @@ static int nxp_simtemp_remove(struct platform_device *pdev)
 
     dev_info(&pdev->dev, "Removing device\n");
 
+    /*
+     * Sysfs goes first: its stores re-arm the timer (or re-join a group),
+     * so the simulator can only be stopped for good once they are gone.
+     */
+    debug_pr_delay("Removing Sysfs\n");
+    nxp_simtemp_sysfs_exit(simtemp);
+
+    /* Disables an enabled IIO buffer, so the timer stops pushing into it */
+    debug_pr_delay("Removing IIO and hwmon\n");
+    nxp_simtemp_iio_exit(simtemp);
+    nxp_simtemp_hwmon_exit(simtemp);
+
     // /* Clean up in reverse order of creation */
     debug_pr_delay("Removing Simulator\n");
     nxp_simtemp_simulator_exit(simtemp);
 
-    debug_pr_delay("Removing Sysfs\n");
-    nxp_simtemp_sysfs_exit(simtemp);
+    debug_pr_delay("Removing Debugfs\n");
+    nxp_simtemp_debugfs_exit(simtemp);
     
     debug_pr_delay("Removing Miscdev\n");
     nxp_simtemp_miscdev_exit(simtemp);
 
-    //mutex is remove by devm_kzalloc automaticlly
+    debug_pr_delay("Removing Aggregation\n");
+    nxp_simtemp_agg_exit(simtemp);
+
+    debug_pr_delay("Removing Buffer\n");
+    nxp_simtemp_buffer_exit(simtemp);
+
+    debug_pr_delay("Removing Stats\n");
+    nxp_simtemp_stats_exit(simtemp);
+
+    debug_pr_delay("Removing Profile\n");
+    nxp_simtemp_profile_exit(simtemp);
+
     debug_pr_delay("Removing Locks\n");
+    nxp_simtemp_locks_exit(simtemp);
+
+    ida_free(&simtemp_ida, simtemp->id);
 
     dev_info(&pdev->dev, "Removing device Done\n");
     return 0;
@@ -195,37 +400,74 @@ static struct platform_driver nxp_simtemp_driver = {
     .driver = {
         .name = "nxp_simtemp",
         .of_match_table = nxp_simtemp_of_match,
+        /* Hundreds of DT nodes probe in parallel, off the boot critical path */
+        .probe_type = PROBE_PREFER_ASYNCHRONOUS,
     },
     .probe = nxp_simtemp_probe,
     .remove = nxp_simtemp_remove,
 };
 
-static struct platform_device *pdev_test;
+static struct platform_device **pdev_test;
+
+/**
+ * @brief Unregisters the first @count module-created platform devices.
+ * @param count Number of entries of pdev_test to release.
+ */
+static void nxp_simtemp_unregister_devices(unsigned int count)
+{
+    while (count--)
+        platform_device_unregister(pdev_test[count]);
+    kfree(pdev_test);
+    pdev_test = NULL;
+}
 
 /**
  * @brief Module initialization function.
  *
- * Registers the platform driver and creates a test platform device.
+ * Registers the platform driver and creates one test platform device per
+ * requested instance (nxp_simtemp.0 .. nxp_simtemp.<instances - 1>).
  *
  * @return int 0 on success, or a negative error code on failure.
  */
 static int __init nxp_simtemp_init(void)
 {
     int ret;
+    unsigned int i;
     pr_info("Initializing NXP simtemp driver\n");
 
+    if (instances < 1 || instances > SIMTEMP_INSTANCES_MAX) {
+        pr_err("instances=%u out of range [1-%u]\n", instances, SIMTEMP_INSTANCES_MAX);
+        return -EINVAL;
+    }
+
+    nxp_simtemp_debugfs_register();
+
     ret = platform_driver_register(&nxp_simtemp_driver);
     if (ret) {
         pr_err("Failed to register platform driver\n");
+        nxp_simtemp_debugfs_unregister();
         return ret;
     }
 
-    pdev_test = platform_device_register_simple("nxp_simtemp", -1, NULL, 0);
-    if (IS_ERR(pdev_test)) {
-        pr_err("Failed to register test platform device\n");
-        platform_driver_unregister(&nxp_simtemp_driver); // Limpieza correcta
-        return PTR_ERR(pdev_test);
+    pdev_test = kcalloc(instances, sizeof(*pdev_test), GFP_KERNEL);
+    if (!pdev_test) {
+        platform_driver_unregister(&nxp_simtemp_driver);
+        nxp_simtemp_debugfs_unregister();
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < instances; i++) {
+        pdev_test[i] = platform_device_register_simple("nxp_simtemp", i, NULL, 0);
+        if (IS_ERR(pdev_test[i])) {
+            pr_err("Failed to register test platform device %u\n", i);
+            ret = PTR_ERR(pdev_test[i]);
+            nxp_simtemp_unregister_devices(i);
+            platform_driver_unregister(&nxp_simtemp_driver); // Limpieza correcta
+            nxp_simtemp_debugfs_unregister();
+            return ret;
+        }
     }
+    pr_info("Created %u simtemp instance(s)\n", instances);
 
 
     return ret;
@@ -234,15 +476,18 @@ static int __init nxp_simtemp_init(void)
 /**
  * @brief Module exit function.
  *
- * Unregisters the platform driver and the test platform device.
+ * Unregisters the platform driver and the test platform devices.
  */
 static void __exit nxp_simtemp_exit(void)
 {
     pr_info("Exiting NXP simtemp driver\n");
     debug_pr_delay("device unregister\n");
-    platform_device_unregister(pdev_test);
+    nxp_simtemp_unregister_devices(instances);
     debug_pr_delay("Driver unregister\n");
     platform_driver_unregister(&nxp_simtemp_driver);
+    nxp_simtemp_debugfs_unregister();
+    rcu_barrier(); /* Files freed by simtemp_release() run their callbacks in this module */
+    ida_destroy(&simtemp_ida);
     debug_pr_delay("Exit Done\n");
 }
 
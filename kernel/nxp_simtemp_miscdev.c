@@ -2,7 +2,7 @@
  * @file    nxp_simtemp_miscdev.c
  * @author  Omar Mendiola
  * @brief   Miscellaneous device implementation for the NXP simtemp driver.
- * Provides a /dev/simtemp interface for userspace to read sensor data.
+ * Provides a /dev/simtemp<N> interface per instance for userspace to read sensor data.
  * @version 0.1
  * @date    2025-10-14
  *
@@ -14,34 +14,116 @@
 #include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
+#include <linux/version.h>
 #include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/rculist.h>
+#include <linux/spinlock.h>
 
 #include "nxp_simtemp.h"
+#include "nxp_simtemp_trace.h"
 
 
 /* --- Wait Queue Condition Macro --- */
 
 /**
- * @brief Checks if a new sample is available under lock.
- * Intended for use as the condition in wait_event_* macros.
- * @param _simtemp Pointer to the struct simtemp_dev.
+ * @brief Checks if the reader behind a file has unread samples.
+ * Lock-free early out of non-blocking read(), which ignores the
+ * watermark. Files in the aggregated format check for window records
+ * instead.
+ * @param _sfile Pointer to the struct simtemp_file.
  * @return True if a new sample is available, false otherwise.
  */
-#define is_new_sample_available(_simtemp) \
-	({ \
-		bool _available; \
-		mutex_lock(&(_simtemp)->lock); \
-		_available = (_simtemp)->new_sample_available; \
-		mutex_unlock(&(_simtemp)->lock); \
-		_available; \
-	})
+#define is_new_sample_available(_sfile) \
+	(READ_ONCE((_sfile)->format) == SIMTEMP_FORMAT_AGG_V1 ? \
+	 nxp_simtemp_agg_has_data((_sfile)->simtemp, READ_ONCE((_sfile)->agg_consumer)) : \
+	 nxp_simtemp_buffer_has_data((_sfile)->simtemp, READ_ONCE((_sfile)->cursor->consumer)))
 
-static u32 timeout_jiffies;
+/**
+ * @brief Checks whether a file is readable under its watermark.
+ *
+ * Ready once lowat samples are pending, or once the oldest pending sample
+ * is older than max_latency_ns. If only the deadline is missing, arms the
+ * file's deadline timer so the waiters are woken when it expires even if no
+ * other sample arrives. Files in the aggregated format are ready on every
+ * window record. Used by the producer on every tick and as the
+ * read()/poll() condition; lock-free.
+ *
+ * @param sfile Per-file state.
+ * @param now_ns Current instance time in nanoseconds (nxp_simtemp_clock_ns()).
+ * @return true if the file should be reported readable.
+ */
+bool nxp_simtemp_file_ready(struct simtemp_file *sfile, u64 now_ns)
+{
+	u64 max_latency_ns = READ_ONCE(sfile->max_latency_ns);
+	u64 pending, oldest_ns = 0;
+
+	if (READ_ONCE(sfile->format) == SIMTEMP_FORMAT_AGG_V1)
+		return nxp_simtemp_agg_has_data(sfile->simtemp, READ_ONCE(sfile->agg_consumer));
+
+	pending = nxp_simtemp_buffer_pending(sfile->simtemp, READ_ONCE(sfile->cursor->consumer),
+	                                     max_latency_ns ? &oldest_ns : NULL);
+	if (!pending)
+		return false;
+	if (pending >= READ_ONCE(sfile->lowat))
+		return true;
+	if (!max_latency_ns)
+		return false;
+	if ((s64)(now_ns - oldest_ns) >= (s64)max_latency_ns)
+		return true;
+
+	/* The timer runs on CLOCK_MONOTONIC; under fast replay the producer's ticks get there first */
+	if (!hrtimer_is_queued(&sfile->deadline_timer))
+		hrtimer_start(&sfile->deadline_timer,
+		              ns_to_ktime(oldest_ns + max_latency_ns - READ_ONCE(sfile->simtemp->clock_offset_ns)),
+		              HRTIMER_MODE_ABS_SOFT);
+	return false;
+}
+
+/**
+ * @brief Deadline timer of a file: the oldest pending sample got too old.
+ * The waiters re-evaluate nxp_simtemp_file_ready() when woken.
+ * @param t Pointer to the hrtimer structure.
+ * @return HRTIMER_NORESTART, re-armed on demand by nxp_simtemp_file_ready().
+ */
+static enum hrtimer_restart simtemp_deadline_callback(struct hrtimer *t)
+{
+	struct simtemp_file *sfile = container_of(t, struct simtemp_file, deadline_timer);
+
+	WRITE_ONCE(sfile->simtemp->last_wake_ns, ktime_get_ns());
+	wake_up_interruptible_poll(&sfile->wq, EPOLLIN | EPOLLRDNORM);
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * @brief Frees a released file once no producer tick can reach it any more.
+ * Runs from softirq after a grace period. The deadline timer is cancelled
+ * here, not in release(): a tick still walking the file may re-arm it
+ * until the grace period ends.
+ * @param head Pointer to the rcu_head embedded in the file.
+ */
+static void simtemp_file_free_rcu(struct rcu_head *head)
+{
+    struct simtemp_file *sfile = container_of(head, struct simtemp_file, rcu);
+
+    hrtimer_cancel(&sfile->deadline_timer);
+    mutex_destroy(&sfile->read_lock);
+    vfree(sfile->cursor); /* Defers to a worker when called from softirq */
+    kfree(sfile->frame);
+    kfree(sfile->aggs);
+    kfree(sfile->batch);
+    kfree(sfile);
+}
 
 static int simtemp_open(struct inode *inode, struct file *filp)
 {
 struct simtemp_dev *simtemp;
+    struct simtemp_file *sfile;
     struct miscdevice *misc_device;
+    int ret;
 
     /* Get Miscdevice from filp->private_data */
     misc_device = filp->private_data;
@@ -62,167 +144,553 @@ struct simtemp_dev *simtemp;
     debug_pr_addr("simtemp_open: misc_device", misc_device);
     debug_pr_addr("simtemp_open: simtemp", simtemp);
 
-    /* Overwrtire private_data to point to simtemp_dev */
-    filp->private_data = simtemp;
+    /* Per-file reader state: each open file gets its own cursor into the FIFO */
+    /* Walked by the producer on every tick: keep it on the node of the sampling CPU */
+    sfile = kzalloc_node(sizeof(*sfile), GFP_KERNEL, nxp_simtemp_node(simtemp));
+    if (!sfile)
+        return -ENOMEM;
+
+    /* Bounce buffer so a batched read needs a single copy to userspace */
+    sfile->batch = kmalloc_array_node(SIMTEMP_READ_BATCH_MAX, sizeof(*sfile->batch), GFP_KERNEL,
+                                      nxp_simtemp_node(simtemp));
+    if (!sfile->batch) {
+        kfree(sfile);
+        return -ENOMEM;
+    }
+
+    /* Cursor lives in its own page so mmap() clients can advance it too */
+    sfile->cursor = vmalloc_user(PAGE_SIZE);
+    if (!sfile->cursor) {
+        kfree(sfile->batch);
+        kfree(sfile);
+        return -ENOMEM;
+    }
+
+    mutex_init(&sfile->read_lock);
+    init_waitqueue_head(&sfile->wq);
+    hrtimer_init(&sfile->deadline_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+    sfile->deadline_timer.function = simtemp_deadline_callback;
+    sfile->lowat = simtemp->lowat; /* 1 unless set in DT: readable on every sample, no deadline */
+    sfile->simtemp = simtemp;
+    sfile->cursor->consumer = nxp_simtemp_buffer_head(simtemp); /* Only samples produced after open */
+    sfile->alert_seen = READ_ONCE(simtemp->alert_seq); /* Only transitions after open */
+
+    /* Lazy mode: the first open starts sampling */
+    ret = nxp_simtemp_simulator_get(simtemp);
+    if (ret) {
+        vfree(sfile->cursor);
+        kfree(sfile->batch);
+        kfree(sfile);
+        return ret;
+    }
+
+    /* From now on the producer wakes this file */
+    spin_lock(&simtemp->files_lock);
+    list_add_tail_rcu(&sfile->node, &simtemp->files);
+    spin_unlock(&simtemp->files_lock);
+
+    /* Overwrtire private_data to point to the per-file state */
+    filp->private_data = sfile;
+
+    /* read_iter() honours IOCB_NOWAIT, so io_uring can poll instead of punting to a worker */
+    filp->f_mode |= FMODE_NOWAIT;
+
+    /* The device is a sample stream: no file position, pread/lseek get -ESPIPE */
+    return stream_open(inode, filp);
+}
+
+/**
+ * @brief Release function for the misc device.
+ *
+ * Called on the last close() of a file. Unlinks the file from the producer
+ * and frees the per-file reader state after a grace period, so close()
+ * never waits for in-flight wake-up passes.
+ * In lazy mode the last file of an instance stops its sampling.
+ *
+ * @param inode Pointer to the inode structure.
+ * @param filp Pointer to the file structure.
+ * @return int Always returns 0.
+ */
+static int simtemp_release(struct inode *inode, struct file *filp)
+{
+    struct simtemp_file *sfile = filp->private_data;
+    struct simtemp_dev *simtemp = sfile->simtemp;
+
+    spin_lock(&simtemp->files_lock);
+    list_del_rcu(&sfile->node);
+    spin_unlock(&simtemp->files_lock);
+    filp->private_data = NULL;
+
+    /* The producer may still be walking the file: free it after a grace period, close does not wait */
+    call_rcu(&sfile->rcu, simtemp_file_free_rcu);
+
+    nxp_simtemp_simulator_put(simtemp);
     return 0;
 }
 
 /**
- * @brief Read function for the misc device.
+ * @brief Read function for the misc device (read(), readv(), io_uring).
  *
  * Called when a userspace application reads from /dev/simtemp. It copies
- * the latest temperature value to the user's buffer.
+ * as many whole samples this file has not read yet as fit in the user's
+ * buffer (up to SIMTEMP_READ_BATCH_MAX) with a single copy_to_iter. Blocks
+ * only while no sample is pending. With SIMTEMP_FORMAT_DELTA_V1 the samples
+ * are returned as one encoded frame instead; samples that do not fit stay
+ * queued for the next read().
  *
- * @param filp Pointer to the file structure.
- * @param buf Userspace buffer to copy data to.
- * @param count Number of bytes to read.
- * @param offp Pointer to the file offset.
+ * IOCB_NOWAIT (io_uring, RWF_NOWAIT) is served like O_NONBLOCK and never
+ * sleeps, not even on the per-file read lock: -EAGAIN makes io_uring arm
+ * simtemp_poll() and retry once the producer wakes the file, so reads stay
+ * in flight without a thread per device and without the blocking timeout.
+ *
+ * @param iocb I/O control block; the file offset is unused (stream).
+ * @param to Destination iterator.
  * @return ssize_t The number of bytes read, or a negative error code.
  */
-static ssize_t simtemp_read(struct file *filp, char __user *buf,
-                             size_t count, loff_t *offp)
+static ssize_t simtemp_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
-struct simtemp_dev *simtemp = filp->private_data;
-	struct simtemp_sample local_sample; /* Local copy to avoid holding lock during copy_to_user */
-	long ret;
-
-	debug_dbg("simtemp_read called, count=%zu, offp=%lld\n", count, *offp);
+	struct file *filp = iocb->ki_filp;
+struct simtemp_file *sfile = filp->private_data;
+	struct simtemp_dev *simtemp;
+	size_t count = iov_iter_count(to);
+	size_t max_samples, min_size, n, k, i, len;
+	const void *out;
+	bool slept = false;
+	bool nowait;
+	u32 format;
+	u64 now_ns, alert_seq;
+	long timeout, ret;
+
+	debug_dbg("simtemp_read called, count=%zu, flags=0x%x\n", count, iocb->ki_flags);
 
 /* Check if simtemp pointer is valid (set in open) */
-	if (!simtemp) {
+	if (!sfile || !sfile->simtemp) {
 		pr_err("simtemp: No device context in file private_data! Was open called?\n");
 		return -ENODEV;
 	}
+	simtemp = sfile->simtemp;
 	debug_pr_addr("simtemp_read: simtemp context", simtemp);
 
 
-/* We only support reading the whole structure from the beginning */
-	if (*offp > 0) {
-		debug_dbg("simtemp_read: EOF condition (*offp > 0)\n");
-		return 0; /* EOF */
-	}
-
-	if (count < sizeof(struct simtemp_sample)) {
+/* Only whole records (or frames) are returned; pairs with the release in SIMTEMP_IOC_SET_FORMAT */
+	format = smp_load_acquire(&sfile->format);
+	if (format == SIMTEMP_FORMAT_DELTA_V1)
+		min_size = sizeof(struct simtemp_frame_hdr);
+	else if (format == SIMTEMP_FORMAT_AGG_V1)
+		min_size = sizeof(struct simtemp_agg_record);
+	else
+		min_size = sizeof(struct simtemp_sample);
+	if (count < min_size) {
 		pr_warn("simtemp: Read buffer too small (%zu bytes provided, %zu needed)\n",
-			count, sizeof(struct simtemp_sample));
+			count, min_size);
 		return -EINVAL; /* Invalid argument */
 	}
+	if (format == SIMTEMP_FORMAT_DELTA_V1)
+		max_samples = SIMTEMP_READ_BATCH_MAX; /* Encoded size is only known after encoding */
+	else if (format == SIMTEMP_FORMAT_AGG_V1)
+		max_samples = min_t(size_t, count / sizeof(struct simtemp_agg_record), SIMTEMP_AGG_DEPTH);
+	else
+		max_samples = min_t(size_t, count / sizeof(struct simtemp_sample), SIMTEMP_READ_BATCH_MAX);
 	/* start Reading process blocking or non-blocking*/
-	if(filp->f_flags & O_NONBLOCK){
-		/* --- Non-blocking Logic --- */
-		debug_dbg("simtemp_read: Non-blocking read requested\n");
-		if(is_new_sample_available(simtemp) == false)
-		{
-			debug_dbg("simtemp_read: Non-blocking read and no new sample available\n");
-			return -EAGAIN; /* No data available */
-		}
+	nowait = (filp->f_flags & O_NONBLOCK) || (iocb->ki_flags & IOCB_NOWAIT);
+	if (nowait && !is_new_sample_available(sfile)) {
+		/* --- Non-blocking Logic: lock-free early out --- */
+		debug_dbg("simtemp_read: Non-blocking read and no new sample available\n");
+		simtemp_stat_inc(simtemp, read_eagain);
+		return -EAGAIN; /* No data available */
 	}
-	else{
-
-		/* --- Blocking Logic with timeout--- */
-		debug_dbg("simtemp_read: Waiting for new sample...\n");
-		/* Sleep until simtemp->new_sample_available is true */
-		ret = wait_event_interruptible_timeout(simtemp->read_wq, is_new_sample_available(simtemp), timeout_jiffies);
-		if (ret < 0) {
-			/* Interrupted by signal */
-			debug_dbg("simtemp_read: Wait interrupted by signal (ret=%ld)\n", ret);
+
+	/*
+	 * Wait lock-free on the file's watermark, then drain under the per-file
+	 * lock. If a thread sharing this file drained it first, a blocking read
+	 * goes back to sleep for what is left of its timeout instead of
+	 * returning -EAGAIN.
+	 */
+	timeout = simtemp->read_timeout_jiffies;
+	for (;;) {
+		if (!nowait && !nxp_simtemp_file_ready(sfile, nxp_simtemp_clock_ns(simtemp))) {
+			/* --- Blocking Logic with timeout--- */
+			debug_dbg("simtemp_read: Waiting for new sample...\n");
+			slept = true;
+			/* Sleep until the file's watermark (or its deadline) is reached */
+			ret = wait_event_interruptible_timeout(sfile->wq,
+			                                       nxp_simtemp_file_ready(sfile, nxp_simtemp_clock_ns(simtemp)),
+			                                       timeout);
+			if (ret < 0) {
+				/* Interrupted by signal */
+				debug_dbg("simtemp_read: Wait interrupted by signal (ret=%ld)\n", ret);
+				return -ERESTARTSYS;
+			} else if (ret == 0) {
+				/* Timeout occurred */
+				pr_warn("simtemp: Read timed out after %d ms waiting for new sample\n",
+						SIMTEMP_READ_TIMEOUT_MS);
+				simtemp_stat_inc(simtemp, read_timeouts);
+				return -ETIMEDOUT; /* Return Timeout error */
+			}
+			/* --- Woken up: ret > 0 jiffies left, a sample is pending for this file --- */
+			timeout = ret;
+			debug_dbg("simtemp_read: Woken up! New sample available.\n");
+		}
+
+		/* --- Drain pending samples into the bounce buffer and advance the cursor --- */
+		if (iocb->ki_flags & IOCB_NOWAIT) {
+			if (!mutex_trylock(&sfile->read_lock))
+				return -EAGAIN; /* Another read of this file is in progress */
+		} else if (mutex_lock_interruptible(&sfile->read_lock)) {
 			return -ERESTARTSYS;
-		} else if (ret == 0) {
-			/* Timeout occurred */
-			pr_warn("simtemp: Read timed out after %d ms waiting for new sample\n",
-					SIMTEMP_READ_TIMEOUT_MS);
-			return -ETIMEDOUT; /* Return Timeout error */
 		}
-		/* --- Woken up: ret > 0, new_sample_available is true --- */
-		debug_dbg("simtemp_read: Woken up! New sample available.\n");
 
+		/* Transitions counted here are in samples already pushed: the read consumes their POLLPRI */
+		alert_seq = READ_ONCE(simtemp->alert_seq);
+		if (format == SIMTEMP_FORMAT_AGG_V1)
+			n = nxp_simtemp_agg_pop(simtemp, &sfile->agg_consumer, sfile->aggs, max_samples);
+		else
+			n = nxp_simtemp_buffer_pop(simtemp, &sfile->cursor->consumer, sfile->batch, max_samples);
+		if (n) {
+			WRITE_ONCE(sfile->alert_seen, alert_seq);
+			break; /* read_lock stays held until the copy is done */
+		}
+		mutex_unlock(&sfile->read_lock);
+
+		/* Another thread sharing this file consumed the samples */
+		if (nowait) {
+			simtemp_stat_inc(simtemp, read_eagain);
+			return -EAGAIN;
+		}
+		debug_dbg("simtemp_read: Samples taken by another reader, waiting again.\n");
 	}
-/* --- At this point, a new sample is available --- */
-/* --- Critical Section: Get the sample and mark it consumed --- */
-mutex_lock(&simtemp->lock);
-	if (!simtemp->new_sample_available) {
-		/* Race condition check: sample consumed between wake-up and lock */
-		mutex_unlock(&simtemp->lock);
-		debug_dbg("simtemp_read: Race condition detected, restarting wait.\n");
-		/* Consider restarting the wait or returning -EAGAIN */
-		/* For simplicity here, we might just return 0 bytes read or an error */
-		/* Or better: retry the wait_event call - but this can get complex */
-		return -EAGAIN; // Indicate user should try again
-	}
-	local_sample = simtemp->latest_sample;
-	simtemp->new_sample_available = false; /* Mark consumed */
-	mutex_unlock(&simtemp->lock);
-/* --- End Critical Section --- */
 
+	if (format == SIMTEMP_FORMAT_DELTA_V1) {
+		/* Encode what fits in the user buffer and give the rest back to the cursor */
+		k = nxp_simtemp_format_encode(sfile->batch, n, sfile->frame,
+		                              min_t(size_t, count, SIMTEMP_FRAME_MAX), &len);
+		WRITE_ONCE(sfile->cursor->consumer, sfile->cursor->consumer - (n - k));
+		n = k;
+		out = sfile->frame;
+	} else if (format == SIMTEMP_FORMAT_AGG_V1) {
+		len = n * sizeof(struct simtemp_agg_record);
+		out = sfile->aggs;
+	} else {
+		len = n * sizeof(struct simtemp_sample);
+		out = sfile->batch;
+	}
 
-/* Copy the local sample to user space */
-	debug_dbg("simtemp_read: Copying sample to user space (size %zu)\n", sizeof(local_sample));
-	if (copy_to_user(buf, &local_sample, sizeof(local_sample))) {
-		pr_err("simtemp: Failed to copy sample to user space\n");
+/* Copy the whole batch to user space in one go */
+	debug_dbg("simtemp_read: Copying %zu samples (%zu bytes) to user space\n", n, len);
+	if (copy_to_iter(out, len, to) != len) {
+		mutex_unlock(&sfile->read_lock);
+		pr_err("simtemp: Failed to copy samples to user space\n");
 		return -EFAULT; /* Bad address */
 	}
 
-	/* Update file offset to indicate we've read the data */
-	*offp += sizeof(local_sample);
-
-	debug_dbg("simtemp_read: Successfully read %zu bytes\n", sizeof(local_sample));
-	return sizeof(local_sample); /* Return the number of bytes successfully read */
+	/* Latency instrumentation: the samples just reached userspace */
+	now_ns = ktime_get_ns();
+	if (slept)
+		nxp_simtemp_latency_record(simtemp, SIMTEMP_LAT_WAKE_TO_READ,
+		                           now_ns - READ_ONCE(simtemp->last_wake_ns));
+	now_ns += READ_ONCE(simtemp->clock_offset_ns); /* Timestamps are on the instance clock */
+	for (i = 0; format != SIMTEMP_FORMAT_AGG_V1 && i < n; i++) /* Window records are not samples */
+		nxp_simtemp_latency_record(simtemp, SIMTEMP_LAT_END_TO_END,
+		                           now_ns - sfile->batch[i].timestamp_ns);
+	trace_read_served(simtemp->id, n, sfile->cursor->consumer);
+	mutex_unlock(&sfile->read_lock);
+
+	simtemp_stat_inc(simtemp, reads);
+	simtemp_stat_add(simtemp, read_bytes, len);
+
+	debug_dbg("simtemp_read: Successfully read %zu bytes\n", len);
+	return len; /* Return the number of bytes successfully read */
 }
 
 /**
  * @brief Poll function for the misc device.
  *
  * Called by poll(), select(), epoll_wait(). Allows userspace to wait
- * efficiently for the device to become readable.
+ * efficiently for the device to become readable. POLLPRI is edge-triggered:
+ * it reports that alert transitions happened since the file last consumed
+ * them, with a read() or SIMTEMP_IOC_ACK_ALERT. poll() itself never consumes
+ * it: the core also calls ->poll when an epoll item is added or rechecked,
+ * and for every select()/poll() pass, and none of these may swallow the
+ * edge. The flags of the read samples tell which alert changed
+ * (SIMTEMP_SAMPLE_FLAG_ALERT_EDGE).
  *
  * @param filp Pointer to the file structure.
  * @param wait Poll table structure used to register wait queues.
- * @return __poll_t Mask indicating device status (POLLIN | POLLRDNORM if readable).
+ * @return __poll_t Mask indicating device status (POLLIN | POLLRDNORM if readable,
+ *         POLLPRI on a pending alert transition).
  */
 static __poll_t simtemp_poll(struct file *filp, poll_table *wait)
 {
 	bool sample_available;
-	u32 sample_flags;
-	struct simtemp_dev *simtemp = filp->private_data;
+	u64 alert_seq;
+	struct simtemp_file *sfile = filp->private_data;
+	struct simtemp_dev *simtemp;
 	__poll_t mask = 0;
 	/*validate simtemp pointer*/
-	if (!simtemp) {
+	if (!sfile || !sfile->simtemp) {
 		pr_err("simtemp: poll: No device context!\n");
 		return EPOLLERR; /* O alguna otra máscara de error apropiada */
 	}
+	simtemp = sfile->simtemp;
 	debug_pr_addr("simtemp_poll: simtemp context", simtemp);
 
 	/* Register the wait queue */
-	poll_wait(filp, &simtemp->read_wq, wait);
+	poll_wait(filp, &sfile->wq, wait);
 
-/*Check current state under lock */
-	mutex_lock(&simtemp->lock);
-	sample_available = simtemp->new_sample_available;
-	sample_flags = simtemp->latest_sample.flags; // Get flags of the latest sample
-	mutex_unlock(&simtemp->lock);
+/*Check current state (lock-free snapshot); POLLIN follows the file's watermark */
+	sample_available = nxp_simtemp_file_ready(sfile, nxp_simtemp_clock_ns(simtemp));
+	alert_seq = READ_ONCE(simtemp->alert_seq);
 
 /*Determine return mask based on state */
 	if (sample_available) {
 		debug_dbg("simtemp_poll: New sample available.\n");
 		mask |= POLLIN | POLLRDNORM; // Device is readable
-
-		/*Check for priority event (threshold) within the available sample */
-		if (sample_flags & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI) {
-			debug_dbg("simtemp_poll: Threshold flag is set in the available sample.\n");
-			mask |= POLLPRI; // Priority condition met
-		}
 	} else {
 		debug_dbg("simtemp_poll: No new sample available yet.\n");
 	}
 
+	/* Priority event: an alert raised or cleared since the file last consumed one */
+	if (alert_seq != READ_ONCE(sfile->alert_seen)) {
+		debug_dbg("simtemp_poll: Alert transition pending.\n");
+		mask |= POLLPRI;
+	}
+
 	return mask;
 }
 
+/**
+ * @brief SIMTEMP_IOC_READ_BATCH: copies buffered samples newer than a timestamp.
+ *
+ * Drains the ring in SIMTEMP_READ_BATCH_MAX chunks through the per-file
+ * bounce buffer, so a catch-up of the whole ring costs one system call.
+ * See struct simtemp_read_batch for the contract.
+ *
+ * @param sfile Per-file state.
+ * @param uarg Userspace struct simtemp_read_batch.
+ * @return long 0 on success, or a negative error code.
+ */
+static long simtemp_ioctl_read_batch(struct simtemp_file *sfile,
+                                     struct simtemp_read_batch __user *uarg)
+{
+	struct simtemp_dev *simtemp = sfile->simtemp;
+	struct simtemp_read_batch req;
+	struct simtemp_sample __user *ubuf;
+	size_t n, skip;
+	u32 total = 0;
+	long ret = 0;
+	u64 seq;
+
+	if (copy_from_user(&req, uarg, sizeof(req)))
+		return -EFAULT;
+	if (req.flags || req.reserved)
+		return -EINVAL;
+	ubuf = u64_to_user_ptr(req.buf);
+
+	if (mutex_lock_interruptible(&sfile->read_lock))
+		return -ERESTARTSYS;
+
+	seq = nxp_simtemp_buffer_seek(simtemp, req.since_timestamp_ns);
+	while (total < req.max) {
+		n = nxp_simtemp_buffer_pop(simtemp, &seq, sfile->batch,
+		                           min_t(u32, req.max - total, SIMTEMP_READ_BATCH_MAX));
+		if (n == 0)
+			break;
+
+		/* The seek may land early when it raced with the producer */
+		for (skip = 0; skip < n && sfile->batch[skip].timestamp_ns <= req.since_timestamp_ns; skip++)
+			;
+		if (copy_to_user(ubuf + total, sfile->batch + skip,
+		                 (n - skip) * sizeof(struct simtemp_sample))) {
+			ret = -EFAULT;
+			break;
+		}
+		total += n - skip;
+	}
+
+	/* read() continues after the last returned sample; it never rewinds */
+	if (!ret && total && (s64)(seq - READ_ONCE(sfile->cursor->consumer)) > 0)
+		WRITE_ONCE(sfile->cursor->consumer, seq);
+	mutex_unlock(&sfile->read_lock);
+	if (ret)
+		return ret;
+
+	if (total) {
+		simtemp_stat_inc(simtemp, reads);
+		simtemp_stat_add(simtemp, read_bytes, (u64)total * sizeof(struct simtemp_sample));
+		trace_read_served(simtemp->id, total, seq);
+	}
+
+	if (put_user(total, &uarg->count))
+		return -EFAULT;
+	return 0;
+}
+
+/**
+ * @brief SIMTEMP_IOC_SET_FORMAT: selects the read() stream format of a file.
+ *
+ * The frame staging and window record buffers are allocated on first use
+ * and kept until release(), so a read() racing with a format change always
+ * finds them. Switching to SIMTEMP_FORMAT_AGG_V1 skips the windows that
+ * closed before.
+ *
+ * @param sfile Per-file state.
+ * @param uarg Userspace __u32 holding a SIMTEMP_FORMAT_* value.
+ * @return long 0 on success, -EINVAL for unknown formats, or a negative error code.
+ */
+static long simtemp_ioctl_set_format(struct simtemp_file *sfile, u32 __user *uarg)
+{
+	u32 format;
+
+	if (get_user(format, uarg))
+		return -EFAULT;
+
+	switch (format) {
+	case SIMTEMP_FORMAT_RAW:
+		break;
+	case SIMTEMP_FORMAT_DELTA_V1:
+		if (mutex_lock_interruptible(&sfile->read_lock))
+			return -ERESTARTSYS;
+		if (!sfile->frame)
+			sfile->frame = kmalloc_node(SIMTEMP_FRAME_MAX, GFP_KERNEL,
+			                            nxp_simtemp_node(sfile->simtemp));
+		mutex_unlock(&sfile->read_lock);
+		if (!sfile->frame)
+			return -ENOMEM;
+		break;
+	case SIMTEMP_FORMAT_AGG_V1:
+		if (mutex_lock_interruptible(&sfile->read_lock))
+			return -ERESTARTSYS;
+		if (!sfile->aggs)
+			sfile->aggs = kmalloc_array_node(SIMTEMP_AGG_DEPTH, sizeof(*sfile->aggs), GFP_KERNEL,
+			                                 nxp_simtemp_node(sfile->simtemp));
+		if (sfile->aggs)
+			sfile->agg_consumer = nxp_simtemp_agg_head(sfile->simtemp);
+		mutex_unlock(&sfile->read_lock);
+		if (!sfile->aggs)
+			return -ENOMEM;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	/* Publish the format after its buffer; pairs with the acquire in read() */
+	smp_store_release(&sfile->format, format);
+	return 0;
+}
+
+/**
+ * @brief SIMTEMP_IOC_SET_WATERMARK: sets when the file becomes readable.
+ * @param sfile Per-file state.
+ * @param uarg Userspace struct simtemp_watermark.
+ * @return long 0 on success, -EINVAL if samples is 0 or above the ring capacity.
+ */
+static long simtemp_ioctl_set_watermark(struct simtemp_file *sfile,
+                                        struct simtemp_watermark __user *uarg)
+{
+	struct simtemp_watermark wm;
+
+	if (copy_from_user(&wm, uarg, sizeof(wm)))
+		return -EFAULT;
+	if (!wm.samples || wm.samples > sfile->simtemp->ring->capacity)
+		return -EINVAL;
+
+	WRITE_ONCE(sfile->lowat, wm.samples);
+	WRITE_ONCE(sfile->max_latency_ns, (u64)wm.max_latency_us * NSEC_PER_USEC);
+
+	/* Let current waiters re-evaluate the new condition */
+	wake_up_interruptible(&sfile->wq);
+	return 0;
+}
+
+/**
+ * @brief Ioctl function for the misc device.
+ *
+ * Commands are defined in nxp_simtemp_uapi.h. The arguments have the
+ * same layout for 32-bit callers, so compat_ptr_ioctl() is enough.
+ *
+ * @param filp Pointer to the file structure.
+ * @param cmd ioctl command.
+ * @param arg Userspace pointer to the command argument.
+ * @return long 0 on success, -ENOTTY for unknown commands, or a negative error code.
+ */
+static long simtemp_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+	struct simtemp_file *sfile = filp->private_data;
+
+	if (!sfile || !sfile->simtemp) {
+		pr_err("simtemp: ioctl: No device context!\n");
+		return -ENODEV;
+	}
+
+	switch (cmd) {
+	case SIMTEMP_IOC_READ_BATCH:
+		return simtemp_ioctl_read_batch(sfile, (void __user *)arg);
+	case SIMTEMP_IOC_SET_FORMAT:
+		return simtemp_ioctl_set_format(sfile, (void __user *)arg);
+	case SIMTEMP_IOC_SET_WATERMARK:
+		return simtemp_ioctl_set_watermark(sfile, (void __user *)arg);
+	case SIMTEMP_IOC_ACK_ALERT:
+		/* Consumers of the mmap()ed ring, which never read() */
+		WRITE_ONCE(sfile->alert_seen, READ_ONCE(sfile->simtemp->alert_seq));
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+/**
+ * @brief Mmap function for the misc device.
+ *
+ * Maps either the device-wide sample ring (read-only) or this file's
+ * consumer cursor page, selected by the mmap() offset (see
+ * nxp_simtemp_uapi.h). Lets clients drain samples with no syscall and
+ * only block in poll() once they caught up with the producer.
+ *
+ * @param filp Pointer to the file structure.
+ * @param vma Virtual memory area requested by userspace.
+ * @return int 0 on success, or a negative error code.
+ */
+static int simtemp_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct simtemp_file *sfile = filp->private_data;
+	u64 offset = (u64)vma->vm_pgoff << PAGE_SHIFT;
+
+	if (!sfile || !sfile->simtemp) {
+		pr_err("simtemp: mmap: No device context!\n");
+		return -ENODEV;
+	}
+
+	/* Device memory: keep the mapping out of mremap() growth and core dumps */
+	vm_flags_set(vma, VM_DONTEXPAND | VM_DONTDUMP);
+
+	switch (offset) {
+	case SIMTEMP_MMAP_OFF_RING:
+		return nxp_simtemp_buffer_mmap(sfile->simtemp, vma);
+	case SIMTEMP_MMAP_OFF_CURSOR:
+		if (vma->vm_end - vma->vm_start != PAGE_SIZE)
+			return -EINVAL;
+		return remap_vmalloc_range(vma, sfile->cursor, 0);
+	default:
+		debug_dbg("simtemp_mmap: invalid offset 0x%llx\n", offset);
+		return -EINVAL;
+	}
+}
+
 static const struct file_operations simtemp_fops = {
     .owner = THIS_MODULE,
     .open = simtemp_open,
-    .read = simtemp_read,
+    .release = simtemp_release,
+    .read_iter = simtemp_read_iter,
+	/* splice()/sendfile(): read_iter() fills the pipe pages directly, no userspace buffer */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+	.splice_read = copy_splice_read,
+#else
+	.splice_read = generic_file_splice_read,
+#endif
 	.poll = simtemp_poll,
+	.mmap = simtemp_mmap,
+	.unlocked_ioctl = simtemp_ioctl,
+	.compat_ioctl = compat_ptr_ioctl,
 	.llseek  = no_llseek,
 };
 
@@ -241,13 +709,18 @@ int nxp_simtemp_miscdev_init(struct simtemp_dev *simtemp)
     struct miscdevice *misc_device = &simtemp->misc_dev;
 
     misc_device->minor = MISC_DYNAMIC_MINOR;
-    misc_device->name = "simtemp";
+    snprintf(simtemp->name, sizeof(simtemp->name), "simtemp%d", simtemp->id);
+    misc_device->name = simtemp->name;
     misc_device->fops = &simtemp_fops;
     /* Set the parent device before registering */
     misc_device->parent = simtemp->dev; //platform device's is the parent
 
+	/* Open files, walked by the producer to wake them (before any open) */
+	spin_lock_init(&simtemp->files_lock);
+	INIT_LIST_HEAD(&simtemp->files);
+
 	/*Calculate bloking read timeout in jiffies just once*/
-	timeout_jiffies = msecs_to_jiffies(SIMTEMP_READ_TIMEOUT_MS); 
+	simtemp->read_timeout_jiffies = msecs_to_jiffies(SIMTEMP_READ_TIMEOUT_MS);
 
      printk(KERN_INFO "Registering misc device: %s\n", misc_device->name); 
 
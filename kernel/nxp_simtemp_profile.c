@@ -0,0 +1,284 @@
+/**
+ * @file    nxp_simtemp_profile.c
+ * @author  Omar Mendiola
+ * @brief   Profile mode of the NXP simtemp driver.
+ * Userspace uploads a table of (dt_us, temp_mc) points through the binary
+ * sysfs attribute "profile" (layout in nxp_simtemp_uapi.h). The upload is
+ * validated and compiled once into segments with a precomputed fixed-point
+ * slope, so the producer only does one multiply and shift per sample to
+ * interpolate. The compiled table is replaced as a whole under RCU: the
+ * producer never waits for an upload and never sees half a table.
+ * @version 0.1
+ * @date    2025-10-27
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/atomic.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/overflow.h>
+#include <linux/rcupdate.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "nxp_simtemp.h"
+
+/* Fractional bits of the segment slopes (mC per us) */
+#define SIMTEMP_PROFILE_FRAC_BITS   16
+#define SIMTEMP_PROFILE_HALF        (1LL << (SIMTEMP_PROFILE_FRAC_BITS - 1)) /* Round to nearest */
+
+/**
+ * @brief One interpolation segment, from a point to the next one.
+ */
+struct simtemp_profile_seg {
+	u64 start_us;       /* Offset of the segment in the table */
+	s64 slope;          /* mC per us, SIMTEMP_PROFILE_FRAC_BITS fractional bits */
+	s32 temp_mc;        /* Temperature at start_us */
+	u32 len_us;         /* Segment length; 0 for a step */
+};
+
+/**
+ * @brief Compiled profile table, immutable once published.
+ */
+struct simtemp_profile {
+	struct rcu_head rcu;
+	u64 id;             /* Unique per upload, lets generators detect a new table */
+	u64 duration_us;    /* Length of one loop of the table */
+	u32 count;          /* Segments, one per point */
+	struct simtemp_profile_seg seg[];
+};
+
+static atomic64_t simtemp_profile_ids = ATOMIC64_INIT(0);
+
+/**
+ * @brief Validates the staged upload and publishes it as the active table.
+ * Called with profile_lock held.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, -EINVAL for an invalid table, or -ENOMEM.
+ */
+static int simtemp_profile_commit(struct simtemp_dev *simtemp)
+{
+	const struct simtemp_profile_hdr *hdr = simtemp->profile_staging;
+	const struct simtemp_profile_point *pt = (const void *)(hdr + 1);
+	struct simtemp_profile *profile, *old;
+	struct simtemp_profile_seg *seg;
+	u64 start_us = 0;
+	u32 i, next;
+
+	for (i = 0; i < hdr->count; i++) {
+		if (pt[i].temp_mc < SIMTEMP_THRESHOLD_MC_MIN || pt[i].temp_mc > SIMTEMP_THRESHOLD_MC_MAX) {
+			pr_warn("simtemp: profile point %u: %d mC out of range [%d, %d]\n",
+			        i, pt[i].temp_mc, SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX);
+			return -EINVAL;
+		}
+	}
+
+	profile = kvzalloc(struct_size(profile, seg, hdr->count), GFP_KERNEL);
+	if (!profile)
+		return -ENOMEM;
+
+	for (i = 0; i < hdr->count; i++) {
+		next = (i + 1) % hdr->count;
+		seg = &profile->seg[i];
+		seg->start_us = start_us;
+		seg->len_us = pt[next].dt_us;
+		seg->temp_mc = pt[i].temp_mc;
+		if (seg->len_us)
+			seg->slope = div64_s64((s64)(pt[next].temp_mc - pt[i].temp_mc) *
+			                     (1LL << SIMTEMP_PROFILE_FRAC_BITS), seg->len_us);
+		start_us += seg->len_us;
+	}
+
+	if (!start_us) {
+		pr_warn("simtemp: profile has zero duration\n");
+		kvfree(profile);
+		return -EINVAL;
+	}
+	profile->duration_us = start_us;
+	profile->count = hdr->count;
+	profile->id = atomic64_inc_return(&simtemp_profile_ids);
+
+	old = rcu_replace_pointer(simtemp->profile, profile, lockdep_is_held(&simtemp->profile_lock));
+	if (old)
+		kvfree_rcu(old, rcu);
+
+	debug_dbg("Profile loaded: %u points, %llu us\n", profile->count, profile->duration_us);
+	return 0;
+}
+
+/**
+ * @brief Drops an incomplete upload.
+ * Called with profile_lock held.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+static void simtemp_profile_discard(struct simtemp_dev *simtemp)
+{
+	kvfree(simtemp->profile_staging);
+	simtemp->profile_staging = NULL;
+	simtemp->profile_staged = 0;
+	simtemp->profile_size = 0;
+}
+
+/**
+ * @brief Receives one chunk of a profile table upload.
+ *
+ * sysfs splits large writes into page-sized chunks. A write at offset 0
+ * starts a new upload and must hold the header; the following chunks must
+ * be contiguous. The table replaces the active one once its last byte
+ * arrives; until then the previous table keeps playing. Any error drops
+ * the upload.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param buf Chunk data.
+ * @param off Offset of the chunk in the table.
+ * @param count Chunk size in bytes.
+ * @return @count on success, or a negative error code.
+ */
+ssize_t nxp_simtemp_profile_write(struct simtemp_dev *simtemp, const char *buf,
+                                  loff_t off, size_t count)
+{
+	struct simtemp_profile_hdr hdr;
+	ssize_t ret = count;
+
+	mutex_lock(&simtemp->profile_lock);
+	if (off == 0) {
+		simtemp_profile_discard(simtemp);
+		if (count < sizeof(hdr)) {
+			ret = -EINVAL;
+			goto out;
+		}
+		memcpy(&hdr, buf, sizeof(hdr));
+		if (hdr.magic != SIMTEMP_PROFILE_MAGIC ||
+		    hdr.count < SIMTEMP_PROFILE_POINTS_MIN || hdr.count > SIMTEMP_PROFILE_POINTS_MAX) {
+			pr_warn("simtemp: invalid profile header (magic 0x%08x, %u points)\n",
+			        hdr.magic, hdr.count);
+			ret = -EINVAL;
+			goto out;
+		}
+		simtemp->profile_size = sizeof(hdr) + hdr.count * sizeof(struct simtemp_profile_point);
+		simtemp->profile_staging = kvmalloc(simtemp->profile_size, GFP_KERNEL);
+		if (!simtemp->profile_staging) {
+			simtemp->profile_size = 0;
+			ret = -ENOMEM;
+			goto out;
+		}
+	} else if (!simtemp->profile_staging || off != simtemp->profile_staged) {
+		/* Chunk of no upload, or out of order */
+		ret = -EINVAL;
+		goto err;
+	}
+
+	if (count > simtemp->profile_size - simtemp->profile_staged) {
+		ret = -EINVAL;
+		goto err;
+	}
+	memcpy(simtemp->profile_staging + simtemp->profile_staged, buf, count);
+	simtemp->profile_staged += count;
+
+	if (simtemp->profile_staged == simtemp->profile_size) {
+		int err = simtemp_profile_commit(simtemp);
+
+		if (err)
+			ret = err;
+		goto err; /* Upload finished either way */
+	}
+	goto out;
+
+err:
+	simtemp_profile_discard(simtemp);
+out:
+	mutex_unlock(&simtemp->profile_lock);
+	return ret;
+}
+
+/**
+ * @brief Checks whether a profile table was uploaded.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return true if mode "profile" has a table to replay.
+ */
+bool nxp_simtemp_profile_loaded(struct simtemp_dev *simtemp)
+{
+	return rcu_access_pointer(simtemp->profile) != NULL;
+}
+
+/**
+ * @brief Generates one block of samples from the profile table.
+ *
+ * Advances the replay position by @step_us per sample, looping at the end
+ * of the table. A newly uploaded table restarts the replay at its first
+ * point. Runs in softirq context.
+ *
+ * @param gen Generator state of the instance.
+ * @param temps Destination, @n entries.
+ * @param n Samples in the block.
+ * @param step_us Table time between two samples, in microseconds.
+ */
+void nxp_simtemp_profile_fill(struct simtemp_gen *gen, s32 *temps, u32 n, u32 step_us)
+{
+	const struct simtemp_profile *profile;
+	const struct simtemp_profile_seg *seg;
+	u64 pos;
+	u32 s, i;
+
+	rcu_read_lock();
+	profile = rcu_dereference(gen->simtemp->profile);
+	if (!profile) {
+		/* No table yet: hold the last temperature */
+		for (i = 0; i < n; i++)
+			temps[i] = gen->temp_mc;
+		goto out;
+	}
+
+	if (gen->profile_id != profile->id) {
+		gen->profile_id = profile->id;
+		gen->profile_pos_us = 0;
+		gen->profile_seg = 0;
+	}
+
+	pos = gen->profile_pos_us;
+	s = gen->profile_seg;
+	for (i = 0; i < n; i++) {
+		/* The last segment ends at duration_us > pos, so this stops */
+		while (pos >= profile->seg[s].start_us + profile->seg[s].len_us)
+			s++;
+		seg = &profile->seg[s];
+		temps[i] = seg->temp_mc +
+		           (s32)((seg->slope * (s64)(pos - seg->start_us) + SIMTEMP_PROFILE_HALF) >>
+		                 SIMTEMP_PROFILE_FRAC_BITS);
+
+		pos += step_us;
+		if (pos >= profile->duration_us) {
+			div64_u64_rem(pos, profile->duration_us, &pos);
+			s = 0;
+		}
+	}
+	gen->profile_pos_us = pos;
+	gen->profile_seg = s;
+out:
+	rcu_read_unlock();
+}
+
+/**
+ * @brief Initializes the profile state of an instance (no table loaded).
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_profile_init(struct simtemp_dev *simtemp)
+{
+	mutex_init(&simtemp->profile_lock);
+	RCU_INIT_POINTER(simtemp->profile, NULL);
+}
+
+/**
+ * @brief Releases the profile table and any pending upload.
+ * Called once the producer and sysfs are gone.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_profile_exit(struct simtemp_dev *simtemp)
+{
+	kvfree(rcu_dereference_protected(simtemp->profile, 1));
+	RCU_INIT_POINTER(simtemp->profile, NULL);
+	simtemp_profile_discard(simtemp);
+	mutex_destroy(&simtemp->profile_lock);
+}
@@ -1,7 +1,13 @@
 /**
  * @file    nxp_simtemp_simulator.c
  * @author  Omar Mendiola
- * @brief   Temperature simulator implementation using a kernel timer.
+ * @brief   Temperature simulator implementation using a high-resolution timer.
+ * The hrtimer expires in softirq context (HRTIMER_MODE_ABS_SOFT) and is
+ * re-armed from its previous expiry, so the sampling period does not drift
+ * with callback latency. With the "grouped" module parameter the timers of
+ * nxp_simtemp_engine.c drive nxp_simtemp_generate() instead. An instance
+ * with a sampling CPU has its timer pinned to that CPU. With the "lazy"
+ * module parameter an instance only samples while someone consumes it.
  * @version 0.1
  * @date    2025-10-14
  *
@@ -9,160 +15,533 @@
  *
  */
 
-#include <linux/timer.h>
-#include <linux/jiffies.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/poll.h>
 #include <linux/random.h>
+#include <linux/rculist.h>
 #include <linux/slab.h>
+#include <linux/smp.h>
 
 #include "nxp_simtemp.h"
 
+#define CREATE_TRACE_POINTS
+#include "nxp_simtemp_trace.h"
+
+static bool grouped;
+module_param(grouped, bool, 0444);
+MODULE_PARM_DESC(grouped, "Service all instances with the same period from one shared timer");
+
+static bool lazy;
+module_param(lazy, bool, 0444);
+MODULE_PARM_DESC(lazy, "Sample only while a file is open or an IIO buffer is enabled");
+
 /**
- * @brief The timer callback function.
- *
- * This function is executed periodically to generate a new temperature value,
- * update statistics, and check for threshold alerts.
- *
- * @param t Pointer to the timer_list structure.
+ * @brief Generates the temperatures of one block.
+ * The mode is resolved once per block so each loop is a tight, branch-light
+ * pass over the block.
+ * @param gen Generator state (ramp position, PRNG).
+ * @param mode Simulation mode.
+ * @param temps Destination, @n entries.
+ * @param n Samples in the block.
+ * @param sampling_us Sampling period, the table time between samples in profile mode.
  */
-static void simtemp_timer_callback(struct timer_list *t)
+static void simtemp_fill_block(struct simtemp_gen *gen, enum simtemp_mode mode,
+                               s32 *temps, u32 n, u32 sampling_us)
 {
-struct simtemp_dev *simtemp = from_timer(simtemp, t, timer);
-	s32 new_temp;
-	struct simtemp_sample sample_temp;
-	struct simtemp_stats stats_temp;
-	s32 threshold;
-	enum simtemp_mode mode;
-	u32 sampling_ms;
-
-	
-	/*Get all the context safety*/
-	mutex_lock(&simtemp->lock);
-	sample_temp = simtemp->latest_sample;
-	threshold = simtemp->threshold_mc;
-	mode = simtemp->mode;
-	sampling_ms = simtemp->sampling_ms;
-	stats_temp = simtemp->stats;
-	mutex_unlock(&simtemp->lock);
-
-	sample_temp.flags = 0; /* Reset flags */
-
-	/* Get current monotonic timestamp BEFORE generating temp */
-	sample_temp.timestamp_ns = ktime_get_ns();
+	s32 temp = gen->temp_mc;
+	u32 i;
 
-	/* --- Temperature Generation Logic --- */
-	// Uses simtemp->latest_sample.temp_mc for ramp mode continuity
 	switch (mode) {
 	case SIMTEMP_MODE_NOISY:
-		get_random_bytes(&new_temp, sizeof(new_temp));
-		new_temp = 25000 + (new_temp % 5000);
+		/* 25 C +/- 5 C; fast per-instance PRNG instead of the CRNG */
+		for (i = 0; i < n; i++)
+			temps[i] = 25000 - 4999 + (s32)(prandom_u32_state(&gen->rnd) % 9999);
 		break;
 	case SIMTEMP_MODE_RAMP:
-		/* Read the previous temp atomically before calculation */
-		new_temp = sample_temp.temp_mc + 100;
-		if (new_temp > 100000)
-			new_temp = 0;
+		// Uses gen->temp_mc for ramp mode continuity
+		for (i = 0; i < n; i++) {
+			temp += 100;
+			if (temp > 100000)
+				temp = 0;
+			temps[i] = temp;
+		}
 		break;
+	case SIMTEMP_MODE_PROFILE:
+		nxp_simtemp_profile_fill(gen, temps, n, sampling_us);
+		return;
 	case SIMTEMP_MODE_NORMAL:
 	default:
-		new_temp = 27500;
+		for (i = 0; i < n; i++)
+			temps[i] = 27500;
 		break;
 	}
+}
+
+/**
+ * @brief Generates one tick worth of samples for an instance.
+ *
+ * Produces nxp_simtemp_gen_block() samples spaced by the sampling period,
+ * evaluates the threshold (with hysteresis) and rate-of-change alerts and
+ * queues them in the instance FIFO, folding them into the aggregation
+ * window if one is set. Every alert transition bumps alert_seq, which turns
+ * into one POLLPRI per file.
+ * In real time the last sample is stamped @now_ns on the instance clock;
+ * with speed > 1 every sample advances the instance clock by a whole
+ * sampling period, so timestamps carry synthetic, accelerated time. Statistics and latest_sample are updated once
+ * per block. Shared by the per-instance timer and the grouped engine; runs
+ * in softirq context. Readers are not woken here so the grouped engine can
+ * wake once per tick.
+ *
+ * @param gen Generator state of the instance.
+ * @param now_ns CLOCK_MONOTONIC time of the tick.
+ * @return Timer period for this configuration (emission period times block size), in microseconds.
+ */
+u32 nxp_simtemp_generate(struct simtemp_gen *gen, u64 now_ns)
+{
+	struct simtemp_dev *simtemp = gen->simtemp;
+	s32 temps[SIMTEMP_GEN_BLOCK_MAX];
+	struct simtemp_sample sample_temp;
+	struct simtemp_config cfg;
+	u32 n, i, emit_us, alerts = 0, errors = 0, edges = 0;
+	u64 period_ns, step_ns, last_ns, offset_ns;
+	s32 threshold, release, prev;
+	u32 state;
 
-	/* Check threshold */
-	if (new_temp > threshold) {
-		sample_temp.flags |= SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI;
+	/*
+	 * Get all the context without sleeping: this runs in softirq context.
+	 * The generator state is private to the producer; the configuration
+	 * is a seqlock snapshot.
+	 */
+	nxp_simtemp_config_read(simtemp, &cfg);
+	threshold = cfg.threshold_mc;
+	release = threshold - (s32)cfg.hysteresis_mc;
+	emit_us = nxp_simtemp_emit_period_us(&cfg);
+	n = nxp_simtemp_gen_block(emit_us);
+	period_ns = (u64)cfg.sampling_us * NSEC_PER_USEC;
+
+	/* Instance clock of the last sample of the block; never goes back */
+	offset_ns = simtemp->clock_offset_ns;
+	step_ns = period_ns;
+	if (cfg.speed > 1) {
+		/* Fast replay: every sample advances the virtual clock a whole period */
+		last_ns = gen->clock_ns + n * period_ns;
+		/* Signed: a virtual clock behind CLOCK_MONOTONIC + offset leaves the offset alone */
+		if ((s64)(last_ns - (now_ns + offset_ns)) > 0)
+			WRITE_ONCE(simtemp->clock_offset_ns, last_ns - now_ns);
+	} else {
+		/*
+		 * Real time: stamp the tick itself and leave the offset alone (it
+		 * is 0 unless a fast replay ran), so late expiries cannot push the
+		 * clock ahead of CLOCK_MONOTONIC. A block that follows a late tick
+		 * spans less than n periods; squeeze its spacing to stay increasing.
+		 */
+		last_ns = max(now_ns + offset_ns, gen->clock_ns + n);
+		if (last_ns - gen->clock_ns < n * period_ns)
+			step_ns = div_u64(last_ns - gen->clock_ns, n);
 	}
+	gen->clock_ns = last_ns;
+
+	/* --- Temperature Generation Logic --- */
+	simtemp_fill_block(gen, cfg.mode, temps, n, cfg.sampling_us);
 
-	if(new_temp < SIMTEMP_THRESHOLD_MC_MIN || new_temp > SIMTEMP_THRESHOLD_MC_MAX) {
-		/* Out of bounds error */
-		sample_temp.flags |= SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE;
+	/* No rate alert across an idle period: the previous sample is not adjacent */
+	prev = gen->gap ? temps[0] : gen->temp_mc;
+	state = gen->alert_state;
+	for (i = 0; i < n; i++) {
+		sample_temp.flags = 0; /* Reset flags */
+		/* Block samples keep their nominal spacing, the last one is "now" */
+		sample_temp.timestamp_ns = last_ns - (n - 1 - i) * step_ns;
+		sample_temp.temp_mc = temps[i];
 
-		pr_warn("simtemp: Generated temperature %d mC out of bounds [%d, %d]\n",
-		        new_temp, SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX);
-		/* Clamp to valid range */
-		if (new_temp < SIMTEMP_THRESHOLD_MC_MIN)
-			new_temp = SIMTEMP_THRESHOLD_MC_MIN;
+		/* Threshold alert: raise above the threshold, clear at or below the release point */
+		if (sample_temp.temp_mc > threshold)
+			state |= SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI;
+		else if (sample_temp.temp_mc <= release)
+			state &= ~SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI;
+
+		/* Rate alert: |delta| / sampling period > limit, without a division */
+		if (cfg.rate_mc_per_s &&
+		    (u64)abs(sample_temp.temp_mc - prev) * USEC_PER_SEC >
+		    (u64)cfg.rate_mc_per_s * cfg.sampling_us)
+			state |= SIMTEMP_SAMPLE_FLAG_RATE_HI;
 		else
-			new_temp = SIMTEMP_THRESHOLD_MC_MAX;
-	}
+			state &= ~SIMTEMP_SAMPLE_FLAG_RATE_HI;
+		prev = sample_temp.temp_mc;
+
+		sample_temp.flags |= state;
+		if (unlikely(gen->gap)) {
+			sample_temp.flags |= SIMTEMP_SAMPLE_FLAG_GAP; /* First sample after a resume */
+			gen->gap = false;
+		}
+		if (state & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI)
+			alerts++;
+		if (state != gen->alert_state) {
+			sample_temp.flags |= SIMTEMP_SAMPLE_FLAG_ALERT_EDGE;
+			gen->alert_state = state;
+			edges++;
+		}
 
-	/*Update countersWS*/
+		if (sample_temp.temp_mc < SIMTEMP_THRESHOLD_MC_MIN ||
+		    sample_temp.temp_mc > SIMTEMP_THRESHOLD_MC_MAX) {
+			/* Out of bounds error */
+			sample_temp.flags |= SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE;
+			errors++;
 
-	stats_temp.updates++;
-	if (sample_temp.flags & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI) {
-		stats_temp.alerts++;
+			pr_warn_ratelimited("simtemp: Generated temperature %d mC out of bounds [%d, %d]\n",
+			                    sample_temp.temp_mc, SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX);
+			/* Clamp to valid range */
+			sample_temp.temp_mc = clamp_t(s32, sample_temp.temp_mc,
+			                              SIMTEMP_THRESHOLD_MC_MIN, SIMTEMP_THRESHOLD_MC_MAX);
+		}
+
+		/*
+		 * Queue the sample for every reader; producer is the sequence it gets.
+		 * Each push publishes its record: the ring protocol only tolerates
+		 * one record written ahead of producer.
+		 */
+		trace_sample_generated(simtemp->id, simtemp->ring->producer, sample_temp.timestamp_ns,
+		                       sample_temp.temp_mc, sample_temp.flags);
+		nxp_simtemp_buffer_push(simtemp, &sample_temp);
+		if (rcu_access_pointer(simtemp->iio_active)) /* IIO buffer enabled */
+			nxp_simtemp_iio_push(simtemp, &sample_temp);
+		if (cfg.agg_window_ms || gen->agg_window_ms)
+			nxp_simtemp_agg_fold(gen, cfg.agg_window_ms, &sample_temp);
 	}
+	gen->temp_mc = sample_temp.temp_mc;
+
+	/*Update counters, once per block*/
+	simtemp_stat_add(simtemp, updates, n);
+	if (alerts)
+		simtemp_stat_add(simtemp, alerts, alerts);
+	if (errors)
+		simtemp_stat_add(simtemp, errors, errors);
+	if (edges)
+		WRITE_ONCE(simtemp->alert_seq, simtemp->alert_seq + edges); /* Single writer */
+
+	/* --- Update Shared State: the newest sample of the block --- */
+	nxp_simtemp_sample_publish(simtemp, &sample_temp);
 
-	if(sample_temp.flags & SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE) {
-		stats_temp.errors++;
+	return emit_us * n;
+}
+
+/**
+ * @brief Wakes up the readers of an instance after new samples were queued.
+ *
+ * Walks the open files and only wakes those with a waiter whose watermark
+ * is reached (see nxp_simtemp_file_ready()) or with an alert transition
+ * pending, so batch consumers are woken once per batch instead of once per
+ * sample, and alert handlers once per transition. Files without a waiter cost
+ * one wq_has_sleeper() check.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_wake_readers(struct simtemp_dev *simtemp)
+{
+	struct simtemp_file *sfile;
+	u64 real_ns = 0, now_ns = 0;
+	__poll_t mask;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(sfile, &simtemp->files, node) {
+		if (!wq_has_sleeper(&sfile->wq))
+			continue;
+		if (!real_ns) {
+			real_ns = ktime_get_ns();
+			now_ns = real_ns + READ_ONCE(simtemp->clock_offset_ns); /* Instance clock */
+		}
+		mask = 0;
+		if (nxp_simtemp_file_ready(sfile, now_ns))
+			mask |= EPOLLIN | EPOLLRDNORM;
+		if (nxp_simtemp_file_alert(sfile))
+			mask |= EPOLLPRI;
+		if (!mask)
+			continue;
+
+		WRITE_ONCE(simtemp->last_wake_ns, real_ns); /* wake-to-read histogram */
+		trace_poll_wakeup(simtemp->id, simtemp->ring->producer);
+		/* The key lets epoll and io_uring poll waiters skip events they did not ask for */
+		wake_up_interruptible_poll(&sfile->wq, mask);
 	}
+	rcu_read_unlock();
+}
 
-	sample_temp.temp_mc = new_temp;
-	/* --- Update Shared State --- */
-	mutex_lock(&simtemp->lock);
+/**
+ * @brief Expiry handed to the CPU a timer is pinned to.
+ */
+struct simtemp_timer_arm {
+	struct hrtimer *timer;
+	ktime_t expires;
+};
 
-	simtemp->stats = stats_temp;
-	simtemp->latest_sample = sample_temp;
+/* Runs on the target CPU (IPI): a pinned timer is queued on the CPU that starts it */
+static void simtemp_timer_start_local(void *info)
+{
+	struct simtemp_timer_arm *arm = info;
 
+	hrtimer_start(arm->timer, arm->expires, HRTIMER_MODE_ABS_PINNED_SOFT);
+}
 
-	/* Mark sample as available */
-	simtemp->new_sample_available = true;
+/**
+ * @brief Starts a sampling timer, pinned to a CPU if one is given.
+ *
+ * A pinned timer keeps firing on the CPU it was started on, so it is started
+ * there with smp_call_function_single(). If that CPU is offline the timer
+ * runs unbound; CPU hotplug later migrates a pinned timer off a CPU that
+ * goes down. Must be called from process context.
+ *
+ * @param timer Sampling timer (HRTIMER_MODE_ABS_SOFT).
+ * @param expires Absolute expiry.
+ * @param cpu Target CPU, or -1 for any.
+ */
+void nxp_simtemp_timer_start(struct hrtimer *timer, ktime_t expires, int cpu)
+{
+	struct simtemp_timer_arm arm = { .timer = timer, .expires = expires };
 
-	mutex_unlock(&simtemp->lock);
-	/* --- End Update Shared State --- */
+	if (cpu >= 0 && !smp_call_function_single(cpu, simtemp_timer_start_local, &arm, 1))
+		return;
+	hrtimer_start(timer, expires, HRTIMER_MODE_ABS_SOFT);
+}
 
+/**
+ * @brief The per-instance timer callback function.
+ *
+ * Used when the grouped engine is disabled: each instance owns a timer.
+ *
+ * @param t Pointer to the hrtimer structure.
+ * @return HRTIMER_RESTART, the timer is re-armed one period after its last expiry.
+ */
+static enum hrtimer_restart simtemp_timer_callback(struct hrtimer *t)
+{
+	struct simtemp_dev *simtemp = container_of(t, struct simtemp_dev, timer);
+	ktime_t now = ktime_get();
+	u32 tick_us;
+
+	/* Phase reference for nxp_simtemp_simulator_update() */
+	WRITE_ONCE(simtemp->last_tick, hrtimer_get_expires(t));
+	nxp_simtemp_latency_record(simtemp, SIMTEMP_LAT_TIMER_JITTER,
+	                           ktime_to_ns(ktime_sub(now, hrtimer_get_expires(t))));
+	tick_us = nxp_simtemp_generate(&simtemp->gen, ktime_to_ns(now));
 
 	/* Wake up any waiting readers */
-	wake_up_interruptible(&simtemp->read_wq);
+	nxp_simtemp_wake_readers(simtemp);
     debug_dbg("Timer: Woke up readers for new sample\n");
 
-	/* Reschedule the timer */
-	mod_timer(&simtemp->timer, jiffies + msecs_to_jiffies(sampling_ms));
+	/*
+	 * Reschedule the timer: advance the expiry by whole periods past now.
+	 * Anchoring on the previous expiry keeps the period drift-free; if the
+	 * callback ran late by more than one period the missed ticks are skipped.
+	 * Sub-millisecond periods tick once per generated block.
+	 */
+	hrtimer_forward_now(t, us_to_ktime(tick_us));
+
+	return HRTIMER_RESTART;
+}
+
+/**
+ * @brief Starts sampling: arms the timer one period from now, or joins the group.
+ * Called with run_lock held.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or a negative error code.
+ */
+static int simtemp_sampling_start(struct simtemp_dev *simtemp)
+{
+	struct simtemp_config cfg;
+	u32 emit_us;
+	int ret;
+
+	nxp_simtemp_config_read(simtemp, &cfg);
+	emit_us = nxp_simtemp_emit_period_us(&cfg);
+	/* Fast replay advances from the last sample: restart it at the resume time, not before */
+	simtemp->gen.clock_ns = max(simtemp->gen.clock_ns, nxp_simtemp_clock_ns(simtemp));
+	if (grouped) {
+		ret = nxp_simtemp_engine_attach(simtemp, emit_us);
+		if (ret)
+			return ret;
+	} else {
+		simtemp->last_tick = ktime_get();
+		nxp_simtemp_timer_start(&simtemp->timer,
+		                        ktime_add_us(simtemp->last_tick, emit_us * nxp_simtemp_gen_block(emit_us)),
+		                        READ_ONCE(simtemp->cpu));
+	}
+	simtemp->running = true;
+	return 0;
+}
+
+/**
+ * @brief Stops sampling; the generator state stays with the instance.
+ * Called with run_lock held. The next sample generated is flagged GAP.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+static void simtemp_sampling_stop(struct simtemp_dev *simtemp)
+{
+	if (grouped)
+		nxp_simtemp_engine_detach(simtemp); /* Copies the generator state back */
+	else
+		hrtimer_cancel(&simtemp->timer);
+	simtemp->running = false;
+	simtemp->gen.gap = true;
+}
+
+/**
+ * @brief Takes a reference on the sampling of an instance.
+ *
+ * With the "lazy" module parameter, open files and enabled IIO buffers hold
+ * a reference each and the first one starts the timer (or joins the group),
+ * so idle instances cause no wake-ups. Without it sampling runs from probe
+ * to remove and nothing is counted. A reference taken before the simulator
+ * is initialized starts sampling at init.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or -ENOMEM (grouped engine).
+ */
+int nxp_simtemp_simulator_get(struct simtemp_dev *simtemp)
+{
+	int ret = 0;
+
+	if (!lazy)
+		return 0;
+
+	mutex_lock(&simtemp->run_lock);
+	if (simtemp->enabled && !simtemp->running) {
+		ret = simtemp_sampling_start(simtemp);
+		if (!ret)
+			debug_dbg("Sampling resumed\n");
+	}
+	if (!ret)
+		simtemp->users++;
+	mutex_unlock(&simtemp->run_lock);
+	return ret;
+}
+
+/**
+ * @brief Drops a reference taken by nxp_simtemp_simulator_get().
+ * The last one stops sampling until the next reference is taken.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_simulator_put(struct simtemp_dev *simtemp)
+{
+	if (!lazy)
+		return;
 
-	/* Debug message (optional) */
-	/* debug_dbg("Timer: New sample generated (%lld ns, %d mC, flags=0x%x)\n",
-		   current_ns, new_temp, flags); */
+	mutex_lock(&simtemp->run_lock);
+	if (!--simtemp->users && simtemp->running) {
+		simtemp_sampling_stop(simtemp);
+		debug_dbg("Sampling idle\n");
+	}
+	mutex_unlock(&simtemp->run_lock);
+}
+
+/**
+ * @brief Applies a configuration change that affects scheduling.
+ *
+ * Called by sysfs after the sampling period, the speed or the sampling CPU
+ * changed, so the change takes effect at once instead of after the old
+ * period. A per-instance timer is re-armed on its CPU one new period after
+ * its last tick, which keeps the phase of the sample grid, or fires
+ * immediately if that time already passed. With the grouped engine the
+ * instance moves to the group of its new period and CPU and follows that
+ * group's phase.
+ *
+ * Mode and threshold need no call: every tick takes a fresh configuration
+ * snapshot, so they apply from the next generated sample. While sampling is
+ * idle (lazy mode) nothing is armed; the next start uses the new values.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or a negative error code.
+ */
+int nxp_simtemp_simulator_update(struct simtemp_dev *simtemp)
+{
+	struct simtemp_config cfg;
+	ktime_t next, now;
+	u32 emit_us;
+	int ret = 0;
+
+	mutex_lock(&simtemp->run_lock);
+	if (!simtemp->running)
+		goto out;
+
+	nxp_simtemp_config_read(simtemp, &cfg);
+	emit_us = nxp_simtemp_emit_period_us(&cfg);
+	if (grouped) {
+		ret = nxp_simtemp_engine_attach(simtemp, emit_us);
+		goto out;
+	}
+
+	/* Waits for a running callback, so last_tick is the latest expiry */
+	hrtimer_cancel(&simtemp->timer);
+	now = ktime_get();
+	next = ktime_add_us(READ_ONCE(simtemp->last_tick), emit_us * nxp_simtemp_gen_block(emit_us));
+	if (ktime_before(next, now))
+		next = now;
+	nxp_simtemp_timer_start(&simtemp->timer, next, READ_ONCE(simtemp->cpu));
+
+	debug_dbg("Timer re-armed for a %u us emission period\n", emit_us);
+out:
+	mutex_unlock(&simtemp->run_lock);
+	return ret;
 }
 
 /**
  * @brief Initializes the simulator.
  *
- * Sets up the initial state and starts the kernel timer.
+ * Sets up the initial state and starts the sampling hrtimer, or joins the
+ * group of its period when the grouped engine is enabled. In lazy mode
+ * sampling only starts here if a reference was already taken.
  *
  * @param dev Pointer to the main simtemp_dev structure.
- * @return int Always returns 0.
+ * @return int 0 on success, or a negative error code.
  */
 int nxp_simtemp_simulator_init(struct simtemp_dev *simtemp)
 {
+    int ret = 0;
+
     /* Set default values */
-    //simtemp->sampling_ms = SIMTEMP_SAMPLING_MS_DEFAULT;
-    //simtemp->threshold_mc = SIMTEMP_THRESHOLD_MC_DEFAULT;
-    simtemp->mode = SIMTEMP_MODE_NORMAL;
+    //simtemp->cfg.sampling_us = SIMTEMP_SAMPLING_MS_DEFAULT * USEC_PER_MSEC;
+    //simtemp->cfg.threshold_mc = SIMTEMP_THRESHOLD_MC_DEFAULT;
+    simtemp->cfg.speed = SIMTEMP_SPEED_MIN;
     simtemp->latest_sample.temp_mc = SIMTEMP_TEMPERATURE_MC_INITIAL; /* Initial temperature 25 C */
 	simtemp->latest_sample.timestamp_ns = ktime_get_ns(); /* Initial timestamp */
 	simtemp->latest_sample.flags = 0; /* Initial flags */
-	simtemp->new_sample_available = false; /* No new sample initially */
+    simtemp->gen.simtemp = simtemp;
+    simtemp->gen.temp_mc = SIMTEMP_TEMPERATURE_MC_INITIAL;
+    simtemp->gen.clock_ns = simtemp->latest_sample.timestamp_ns;
+    prandom_seed_state(&simtemp->gen.rnd, get_random_u64());
+    simtemp->gen.gap = lazy; /* Lazy: idle from probe until the first consumer */
 
-    /* Initialize the wait queue */
-	init_waitqueue_head(&simtemp->read_wq);
+    /* Setup the timer (per-instance sampling) */
+    hrtimer_init(&simtemp->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+    simtemp->timer.function = simtemp_timer_callback;
 
-    /* Setup and start the timer */
-    timer_setup(&simtemp->timer, simtemp_timer_callback, 0);
-    mod_timer(&simtemp->timer, jiffies + msecs_to_jiffies(simtemp->sampling_ms));
+    mutex_lock(&simtemp->run_lock);
+    simtemp->enabled = true;
+    if (!lazy || simtemp->users) {
+        ret = simtemp_sampling_start(simtemp);
+        if (ret)
+            simtemp->enabled = false;
+    }
+    mutex_unlock(&simtemp->run_lock);
 
-    debug_dbg("Simulator initialized. Timer started.\n");
+    debug_dbg("Simulator initialized (%s)\n", simtemp->running ? "sampling" : "idle");
 
-    return 0;
+    return ret;
 }
 
 /**
  * @brief Deinitializes the simulator.
  *
- * Stops the kernel timer.
+ * Stops the sampling hrtimer, or leaves the group. References dropped after
+ * this point do not restart it.
  *
  * @param dev Pointer to the main simtemp_dev structure.
  */
 void nxp_simtemp_simulator_exit(struct simtemp_dev *simtemp)
 {
-    del_timer_sync(&simtemp->timer);
+    mutex_lock(&simtemp->run_lock);
+    simtemp->enabled = false;
+    if (simtemp->running)
+        simtemp_sampling_stop(simtemp);
+    mutex_unlock(&simtemp->run_lock);
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * @file    nxp_simtemp_stats.c
+ * @author  Omar Mendiola
+ * @brief   Per-CPU statistics of the NXP simtemp driver.
+ * The producer and the readers bump counters in their CPU's copy of
+ * struct simtemp_stats with this_cpu ops (simtemp_stat_inc/add), so no
+ * lock or shared cache line is touched on the hot paths. Readers of the
+ * statistics sum all copies; the result is not an atomic snapshot across
+ * counters, which is fine for monitoring. The latency histograms of
+ * nxp_simtemp_debugfs.c use the same scheme.
+ * @version 0.1
+ * @date    2025-10-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <linux/percpu.h>
+#include <linux/string.h>
+
+#include "nxp_simtemp.h"
+
+/**
+ * @brief Sums the per-CPU statistics of an instance.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param stats Destination for the totals.
+ */
+void nxp_simtemp_stats_read(struct simtemp_dev *simtemp, struct simtemp_stats *stats)
+{
+	int cpu;
+
+	memset(stats, 0, sizeof(*stats));
+	for_each_possible_cpu(cpu) {
+		const struct simtemp_stats *pcpu = per_cpu_ptr(simtemp->pcpu_stats, cpu);
+
+		stats->updates += READ_ONCE(pcpu->updates);
+		stats->alerts += READ_ONCE(pcpu->alerts);
+		stats->errors += READ_ONCE(pcpu->errors);
+		stats->reads += READ_ONCE(pcpu->reads);
+		stats->read_bytes += READ_ONCE(pcpu->read_bytes);
+		stats->read_eagain += READ_ONCE(pcpu->read_eagain);
+		stats->read_timeouts += READ_ONCE(pcpu->read_timeouts);
+		stats->dropped += READ_ONCE(pcpu->dropped);
+	}
+}
+
+/**
+ * @brief Sums one latency histogram over all CPUs.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param hist Histogram to read.
+ * @param buckets Destination, SIMTEMP_LAT_BUCKETS entries.
+ */
+void nxp_simtemp_latency_read(struct simtemp_dev *simtemp, enum simtemp_lat_hist hist,
+                              u64 buckets[SIMTEMP_LAT_BUCKETS])
+{
+	int cpu, b;
+
+	memset(buckets, 0, SIMTEMP_LAT_BUCKETS * sizeof(buckets[0]));
+	for_each_possible_cpu(cpu) {
+		const struct simtemp_latency *pcpu = per_cpu_ptr(simtemp->pcpu_latency, cpu);
+
+		for (b = 0; b < SIMTEMP_LAT_BUCKETS; b++)
+			buckets[b] += READ_ONCE(pcpu->bucket[hist][b]);
+	}
+}
+
+/**
+ * @brief Clears all latency histograms.
+ * Increments racing with the reset may survive it.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_latency_reset(struct simtemp_dev *simtemp)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(simtemp->pcpu_latency, cpu), 0, sizeof(struct simtemp_latency));
+}
+
+/**
+ * @brief Allocates the zeroed per-CPU counters and latency histograms.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @return int 0 on success, or -ENOMEM.
+ */
+int nxp_simtemp_stats_init(struct simtemp_dev *simtemp)
+{
+	simtemp->pcpu_stats = alloc_percpu(struct simtemp_stats);
+	if (!simtemp->pcpu_stats)
+		return -ENOMEM;
+
+	simtemp->pcpu_latency = alloc_percpu(struct simtemp_latency);
+	if (!simtemp->pcpu_latency) {
+		free_percpu(simtemp->pcpu_stats);
+		simtemp->pcpu_stats = NULL;
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+/**
+ * @brief Releases the per-CPU counters and latency histograms.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ */
+void nxp_simtemp_stats_exit(struct simtemp_dev *simtemp)
+{
+	free_percpu(simtemp->pcpu_latency);
+	simtemp->pcpu_latency = NULL;
+	free_percpu(simtemp->pcpu_stats);
+	simtemp->pcpu_stats = NULL;
+}
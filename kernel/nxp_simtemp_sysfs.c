@@ -14,24 +14,91 @@
 #include <linux/device.h>
 #include <linux/string.h>
 #include <linux/slab.h>
+#include <linux/cpumask.h>
 
 #include "nxp_simtemp.h"
 
+/* Fields of a configuration change (config attribute, single attributes) */
+#define SIMTEMP_CFG_SAMPLING    BIT(0)
+#define SIMTEMP_CFG_THRESHOLD   BIT(1)
+#define SIMTEMP_CFG_MODE        BIT(2)
+#define SIMTEMP_CFG_SPEED       BIT(3)
+#define SIMTEMP_CFG_HYSTERESIS  BIT(4)
+#define SIMTEMP_CFG_RATE        BIT(5)
+#define SIMTEMP_CFG_AGG_WINDOW  BIT(6)
+#define SIMTEMP_CFG_SCHEDULE    (SIMTEMP_CFG_SAMPLING | SIMTEMP_CFG_SPEED)
+
+/* Publishes the fields of @cfg selected by @set; the others are left alone */
+static void simtemp_config_write(struct simtemp_dev *simtemp, const struct simtemp_config *cfg,
+                                 unsigned int set)
+{
+	write_seqlock_bh(&simtemp->cfg_lock);
+	if (set & SIMTEMP_CFG_SAMPLING)
+		simtemp->cfg.sampling_us = cfg->sampling_us;
+	if (set & SIMTEMP_CFG_THRESHOLD)
+		simtemp->cfg.threshold_mc = cfg->threshold_mc;
+	if (set & SIMTEMP_CFG_MODE)
+		simtemp->cfg.mode = cfg->mode;
+	if (set & SIMTEMP_CFG_SPEED)
+		simtemp->cfg.speed = cfg->speed;
+	if (set & SIMTEMP_CFG_HYSTERESIS)
+		simtemp->cfg.hysteresis_mc = cfg->hysteresis_mc;
+	if (set & SIMTEMP_CFG_RATE)
+		simtemp->cfg.rate_mc_per_s = cfg->rate_mc_per_s;
+	if (set & SIMTEMP_CFG_AGG_WINDOW)
+		simtemp->cfg.agg_window_ms = cfg->agg_window_ms;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+}
+
+/**
+ * @brief Publishes a configuration change and re-schedules the instance.
+ *
+ * A period or speed change re-arms the timer (or moves the instance to
+ * another group). If that fails (grouped engine: no memory for the new
+ * group) every given field is restored, so cfg keeps matching the timer or
+ * group the instance is in and a failed store applies nothing. Every
+ * writer of cfg takes sched_lock, so the restore cannot undo a concurrent
+ * store to another field.
+ *
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param cfg Values to apply.
+ * @param set SIMTEMP_CFG_* bits of the fields to apply.
+ * @return int 0 on success, or a negative error code.
+ */
+static int simtemp_config_commit(struct simtemp_dev *simtemp, const struct simtemp_config *cfg,
+                                 unsigned int set)
+{
+	struct simtemp_config old;
+	int ret = 0;
+
+	mutex_lock(&simtemp->sched_lock);
+	nxp_simtemp_config_read(simtemp, &old);
+	simtemp_config_write(simtemp, cfg, set);
+	if (set & SIMTEMP_CFG_SCHEDULE) {
+		/* Re-arm the timer (or move group) now instead of after the old period */
+		ret = nxp_simtemp_simulator_update(simtemp);
+		if (ret)
+			simtemp_config_write(simtemp, &old, set);
+	}
+	mutex_unlock(&simtemp->sched_lock);
+	return ret;
+}
+
 /* --- sampling_ms attribute --- */
 static ssize_t sampling_ms_show(struct device *dev,
                                 struct device_attribute *attr, char *buf)
 {
 struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
 	if (!simtemp) return -ENODEV;
 
 	debug_pr_addr("show: dev    ", dev);
 	debug_pr_addr("show: simtemp", simtemp);
 
-    mutex_lock(&simtemp->lock);
-    u32 sampling_ms = simtemp->sampling_ms;
-    mutex_unlock(&simtemp->lock);
+    nxp_simtemp_config_read(simtemp, &cfg);
 
-	return sysfs_emit(buf, "%u\n", sampling_ms);
+	/* Periods set through sampling_us are reported rounded down */
+	return sysfs_emit(buf, "%u\n", cfg.sampling_us / USEC_PER_MSEC);
 }
 
 static ssize_t sampling_ms_store(struct device *dev,
@@ -39,6 +106,7 @@ static ssize_t sampling_ms_store(struct device *dev,
                                  const char *buf, size_t count)
 {
     struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
 	unsigned long val;
 	int ret;
 
@@ -58,28 +126,121 @@ static ssize_t sampling_ms_store(struct device *dev,
 	}
 	/* --- END VALIDATION --- */
 
-	mutex_lock(&simtemp->lock);
-	simtemp->sampling_ms = (u32)val;
-	/* Optionally: Restart timer immediately with new value, or let the next callback handle it */
-	/* mod_timer(&simtemp->timer, jiffies + msecs_to_jiffies(simtemp->sampling_ms)); */
-	mutex_unlock(&simtemp->lock);
+	cfg.sampling_us = (u32)val * USEC_PER_MSEC;
+	ret = simtemp_config_commit(simtemp, &cfg, SIMTEMP_CFG_SAMPLING);
+	if (ret)
+		return ret;
 
-	debug_dbg("sampling_ms set to %u\n", simtemp->sampling_ms);
+	debug_dbg("sampling_ms set to %lu\n", val);
 	return count;
 }
 static DEVICE_ATTR_RW(sampling_ms);
 
+/* --- sampling_us attribute --- */
+static ssize_t sampling_us_show(struct device *dev,
+                                struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%u\n", cfg.sampling_us);
+}
+
+static ssize_t sampling_us_store(struct device *dev,
+                                 struct device_attribute *attr,
+                                 const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	unsigned long val;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtoul(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for sampling_us: '%s'\n", buf);
+		return ret;
+	}
+
+	/* --- VALIDATION --- */
+	if (val < SIMTEMP_SAMPLING_US_MIN || val > SIMTEMP_SAMPLING_US_MAX) {
+		pr_warn("simtemp: sampling_us value %lu out of range [%u-%u]\n",
+		        val, SIMTEMP_SAMPLING_US_MIN, SIMTEMP_SAMPLING_US_MAX);
+		return -EINVAL; /* Invalid argument */
+	}
+	/* --- END VALIDATION --- */
+
+	cfg.sampling_us = (u32)val;
+	ret = simtemp_config_commit(simtemp, &cfg, SIMTEMP_CFG_SAMPLING);
+	if (ret)
+		return ret;
+
+	debug_dbg("sampling_us set to %lu\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(sampling_us);
+
+/* --- speed attribute --- */
+static ssize_t speed_show(struct device *dev,
+                          struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%u\n", cfg.speed);
+}
+
+static ssize_t speed_store(struct device *dev,
+                           struct device_attribute *attr,
+                           const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	unsigned long val;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtoul(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for speed: '%s'\n", buf);
+		return ret;
+	}
+
+	/* --- VALIDATION --- */
+	if (val < SIMTEMP_SPEED_MIN || val > SIMTEMP_SPEED_MAX) {
+		pr_warn("simtemp: speed value %lu out of range [%u-%u]\n",
+		        val, SIMTEMP_SPEED_MIN, SIMTEMP_SPEED_MAX);
+		return -EINVAL; /* Invalid argument */
+	}
+	/* --- END VALIDATION --- */
+
+	/* Samples keep sampling_us of virtual spacing, emitted speed times faster */
+	cfg.speed = (u32)val;
+	ret = simtemp_config_commit(simtemp, &cfg, SIMTEMP_CFG_SPEED);
+	if (ret)
+		return ret;
+
+	debug_dbg("speed set to %lu\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(speed);
+
 /* --- threshold_mc attribute --- */
 static ssize_t threshold_mc_show(struct device *dev,
                                  struct device_attribute *attr, char *buf)
 {
     struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
 	if (!simtemp) return -ENODEV;
 
-    mutex_lock(&simtemp->lock);
-    s32 threshold_mc = simtemp->threshold_mc;
-    mutex_unlock(&simtemp->lock);
-	return sysfs_emit(buf, "%d\n", threshold_mc);
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%d\n", cfg.threshold_mc);
 }
 
 static ssize_t threshold_mc_store(struct device *dev,
@@ -106,36 +267,232 @@ static ssize_t threshold_mc_store(struct device *dev,
 	}
 	/* --- END VALIDATION --- */
 
-	mutex_lock(&simtemp->lock);
-	simtemp->threshold_mc = (s32)val;
-	mutex_unlock(&simtemp->lock);
+	mutex_lock(&simtemp->sched_lock);
+	write_seqlock_bh(&simtemp->cfg_lock);
+	simtemp->cfg.threshold_mc = (s32)val;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+	mutex_unlock(&simtemp->sched_lock);
 
-	debug_dbg("threshold_mc set to %d\n", simtemp->threshold_mc);
+	debug_dbg("threshold_mc set to %ld\n", val);
 	return count;
 }
 static DEVICE_ATTR_RW(threshold_mc);
 
+/* --- hysteresis_mc attribute --- */
+static ssize_t hysteresis_mc_show(struct device *dev,
+                                  struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%u\n", cfg.hysteresis_mc);
+}
+
+/* Width of the band below threshold_mc where an active alert stays active */
+static ssize_t hysteresis_mc_store(struct device *dev,
+                                   struct device_attribute *attr,
+                                   const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtouint(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for hysteresis_mc: '%s'\n", buf);
+		return ret;
+	}
+
+	if (val > SIMTEMP_HYSTERESIS_MC_MAX) {
+		pr_warn("simtemp: hysteresis_mc value %u out of range [0-%d]\n",
+		        val, SIMTEMP_HYSTERESIS_MC_MAX);
+		return -EINVAL;
+	}
+
+	mutex_lock(&simtemp->sched_lock);
+	write_seqlock_bh(&simtemp->cfg_lock);
+	simtemp->cfg.hysteresis_mc = val;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+	mutex_unlock(&simtemp->sched_lock);
+
+	debug_dbg("hysteresis_mc set to %u\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(hysteresis_mc);
+
+/* --- rate_mc_per_s attribute --- */
+static ssize_t rate_mc_per_s_show(struct device *dev,
+                                  struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%u\n", cfg.rate_mc_per_s);
+}
+
+/* Rate-of-change alert limit in mC per second of sample time; 0 disables it */
+static ssize_t rate_mc_per_s_store(struct device *dev,
+                                   struct device_attribute *attr,
+                                   const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtouint(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for rate_mc_per_s: '%s'\n", buf);
+		return ret;
+	}
+
+	if (val > SIMTEMP_RATE_MC_S_MAX) {
+		pr_warn("simtemp: rate_mc_per_s value %u out of range [0-%d]\n",
+		        val, SIMTEMP_RATE_MC_S_MAX);
+		return -EINVAL;
+	}
+
+	mutex_lock(&simtemp->sched_lock);
+	write_seqlock_bh(&simtemp->cfg_lock);
+	simtemp->cfg.rate_mc_per_s = val;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+	mutex_unlock(&simtemp->sched_lock);
+
+	debug_dbg("rate_mc_per_s set to %u\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(rate_mc_per_s);
+
+/* --- agg_window_ms attribute --- */
+static ssize_t agg_window_ms_show(struct device *dev,
+                                  struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "%u\n", cfg.agg_window_ms);
+}
+
+/* Window of the SIMTEMP_FORMAT_AGG_V1 records; 0 stops the aggregation */
+static ssize_t agg_window_ms_store(struct device *dev,
+                                   struct device_attribute *attr,
+                                   const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtouint(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for agg_window_ms: '%s'\n", buf);
+		return ret;
+	}
+
+	if (val && (val < SIMTEMP_AGG_WINDOW_MS_MIN || val > SIMTEMP_AGG_WINDOW_MS_MAX)) {
+		pr_warn("simtemp: agg_window_ms value %u out of range [%d-%d] (0 = off)\n",
+		        val, SIMTEMP_AGG_WINDOW_MS_MIN, SIMTEMP_AGG_WINDOW_MS_MAX);
+		return -EINVAL;
+	}
+
+	mutex_lock(&simtemp->sched_lock);
+	write_seqlock_bh(&simtemp->cfg_lock);
+	simtemp->cfg.agg_window_ms = val;
+	write_sequnlock_bh(&simtemp->cfg_lock);
+	mutex_unlock(&simtemp->sched_lock);
+
+	debug_dbg("agg_window_ms set to %u\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(agg_window_ms);
+
+
+/* --- cpu attribute --- */
+static ssize_t cpu_show(struct device *dev,
+                        struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	if (!simtemp) return -ENODEV;
+
+	return sysfs_emit(buf, "%d\n", READ_ONCE(simtemp->cpu));
+}
+
+/*
+ * Pins the sampling timer to an online CPU, or unpins it with -1. The
+ * sample ring keeps the node it was allocated on at probe; set the DT "cpu"
+ * property to place it as well.
+ */
+static ssize_t cpu_store(struct device *dev,
+                         struct device_attribute *attr,
+                         const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	int val, old;
+	int ret;
+
+	if (!simtemp) return -ENODEV;
+
+	ret = kstrtoint(buf, 10, &val);
+	if (ret) {
+		pr_err("simtemp: Invalid input for cpu: '%s'\n", buf);
+		return ret;
+	}
+
+	/* --- VALIDATION --- */
+	if (val < -1 || val >= (int)nr_cpu_ids || (val >= 0 && !cpu_online(val))) {
+		pr_warn("simtemp: cpu %d is not -1 or an online CPU\n", val);
+		return -EINVAL; /* Invalid argument */
+	}
+	/* --- END VALIDATION --- */
+
+	mutex_lock(&simtemp->sched_lock);
+	old = READ_ONCE(simtemp->cpu);
+	WRITE_ONCE(simtemp->cpu, val);
+
+	/* Re-arm the timer on the new CPU (or move to the group of that CPU) */
+	ret = nxp_simtemp_simulator_update(simtemp);
+	if (ret)
+		WRITE_ONCE(simtemp->cpu, old);
+	mutex_unlock(&simtemp->sched_lock);
+	if (ret)
+		return ret;
+
+	debug_dbg("cpu set to %d\n", val);
+	return count;
+}
+static DEVICE_ATTR_RW(cpu);
 
 /* --- mode attribute --- */
-static const char * const simtemp_modes[] = {
+const char * const nxp_simtemp_modes[SIMTEMP_MODE_MAX] = {
     [SIMTEMP_MODE_NORMAL] = "normal",
     [SIMTEMP_MODE_NOISY] = "noisy",
     [SIMTEMP_MODE_RAMP] = "ramp",
+    [SIMTEMP_MODE_PROFILE] = "profile",
 };
 
 static ssize_t mode_show(struct device *dev,
                          struct device_attribute *attr, char *buf)
 {
     struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
 	if (!simtemp) return -ENODEV;
 
-    mutex_lock(&simtemp->lock);
-    enum simtemp_mode mode = simtemp->mode;
-    mutex_unlock(&simtemp->lock);
+    nxp_simtemp_config_read(simtemp, &cfg);
+    enum simtemp_mode mode = cfg.mode;
 	/* Check bounds in case mode is somehow corrupted */
 	if (mode >= SIMTEMP_MODE_MAX || mode < 0)
 		return sysfs_emit(buf, "invalid\n");
-	return sysfs_emit(buf, "%s\n", simtemp_modes[mode]);
+	return sysfs_emit(buf, "%s\n", nxp_simtemp_modes[mode]);
 }
 
 static ssize_t mode_store(struct device *dev,
@@ -148,16 +505,22 @@ static ssize_t mode_store(struct device *dev,
 	if (!simtemp) return -ENODEV;
 
 	for (i = 0; i < SIMTEMP_MODE_MAX; i++) {
-		if (sysfs_streq(buf, simtemp_modes[i])) {
-			mutex_lock(&simtemp->lock);
-			simtemp->mode = i;
-			mutex_unlock(&simtemp->lock);
-			debug_dbg("mode set to %s\n", simtemp_modes[i]);
+		if (sysfs_streq(buf, nxp_simtemp_modes[i])) {
+			if (i == SIMTEMP_MODE_PROFILE && !nxp_simtemp_profile_loaded(simtemp)) {
+				pr_warn("simtemp: mode profile needs a table, write it to 'profile' first\n");
+				return -ENODATA;
+			}
+			mutex_lock(&simtemp->sched_lock);
+			write_seqlock_bh(&simtemp->cfg_lock);
+			simtemp->cfg.mode = i;
+			write_sequnlock_bh(&simtemp->cfg_lock);
+			mutex_unlock(&simtemp->sched_lock);
+			debug_dbg("mode set to %s\n", nxp_simtemp_modes[i]);
 			return count;
 		}
 	}
 
-	pr_warn("simtemp: Invalid mode value: '%s'. Valid modes: normal, noisy, ramp\n", buf);
+	pr_warn("simtemp: Invalid mode value: '%s'. Valid modes: normal, noisy, ramp, profile\n", buf);
 	return -EINVAL;
 }
 static DEVICE_ATTR_RW(mode);
@@ -167,35 +530,206 @@ static ssize_t stats_show(struct device *dev,
                           struct device_attribute *attr, char *buf)
 {
     struct simtemp_dev *simtemp = dev_get_drvdata(dev);
-	u64 updates, alerts, errors; /* Use local vars to minimize lock time */
+	struct simtemp_stats stats; /* Sum of the per-CPU counters, never blocks the producer */
 
 	if (!simtemp) return -ENODEV;
 
-	/* Get stats atomically */
-	mutex_lock(&simtemp->lock);
-	updates = simtemp->stats.updates;
-	alerts = simtemp->stats.alerts;
-	errors = simtemp->stats.errors;
-	mutex_unlock(&simtemp->lock);
+	nxp_simtemp_stats_read(simtemp, &stats);
 
-	return sysfs_emit(buf, "updates=%llu alerts=%llu errors=%llu\n",
-	                  updates, alerts, errors);
+	return sysfs_emit(buf, "updates=%llu alerts=%llu errors=%llu dropped=%llu "
+	                  "reads=%llu read_bytes=%llu eagain=%llu timeouts=%llu\n",
+	                  stats.updates, stats.alerts, stats.errors, stats.dropped,
+	                  stats.reads, stats.read_bytes, stats.read_eagain, stats.read_timeouts);
 }
 
 static DEVICE_ATTR_RO(stats);
 
+/* --- config attribute (all parameters at once) --- */
+static ssize_t config_show(struct device *dev,
+                           struct device_attribute *attr, char *buf)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg;
+	if (!simtemp) return -ENODEV;
+
+	/* One snapshot, so the line is always a configuration the producer used */
+    nxp_simtemp_config_read(simtemp, &cfg);
+	return sysfs_emit(buf, "sampling_us=%u threshold_mc=%d mode=%s speed=%u "
+	                  "hysteresis_mc=%u rate_mc_per_s=%u agg_window_ms=%u\n",
+	                  cfg.sampling_us, cfg.threshold_mc,
+	                  cfg.mode < SIMTEMP_MODE_MAX ? nxp_simtemp_modes[cfg.mode] : "invalid",
+	                  cfg.speed, cfg.hysteresis_mc, cfg.rate_mc_per_s, cfg.agg_window_ms);
+}
+
+/**
+ * @brief Parses one key=value pair into a staged configuration.
+ * Same limits as the individual attributes.
+ * @param simtemp Pointer to the main simtemp_dev structure.
+ * @param key Parameter name.
+ * @param val Parameter value.
+ * @param cfg Staged values.
+ * @param set Receives the SIMTEMP_CFG_* bit of the parameter.
+ * @return int 0 on success, or a negative error code.
+ */
+static int simtemp_config_parse(struct simtemp_dev *simtemp, const char *key, const char *val,
+                                struct simtemp_config *cfg, unsigned int *set)
+{
+	unsigned long uval;
+	long sval;
+	int i;
+
+	if (!strcmp(key, "mode")) {
+		for (i = 0; i < SIMTEMP_MODE_MAX; i++) {
+			if (!strcmp(val, nxp_simtemp_modes[i])) {
+				if (i == SIMTEMP_MODE_PROFILE && !nxp_simtemp_profile_loaded(simtemp))
+					return -ENODATA;
+				cfg->mode = i;
+				*set |= SIMTEMP_CFG_MODE;
+				return 0;
+			}
+		}
+		return -EINVAL;
+	}
+
+	if (!strcmp(key, "threshold_mc")) {
+		if (kstrtol(val, 10, &sval) ||
+		    sval < SIMTEMP_THRESHOLD_MC_MIN || sval > SIMTEMP_THRESHOLD_MC_MAX)
+			return -EINVAL;
+		cfg->threshold_mc = (s32)sval;
+		*set |= SIMTEMP_CFG_THRESHOLD;
+		return 0;
+	}
+
+	if (kstrtoul(val, 10, &uval))
+		return -EINVAL;
+	if (!strcmp(key, "sampling_ms")) {
+		if (uval < SIMTEMP_SAMPLING_MS_MIN || uval > SIMTEMP_SAMPLING_MS_MAX)
+			return -EINVAL;
+		cfg->sampling_us = (u32)uval * USEC_PER_MSEC;
+		*set |= SIMTEMP_CFG_SAMPLING;
+	} else if (!strcmp(key, "sampling_us")) {
+		if (uval < SIMTEMP_SAMPLING_US_MIN || uval > SIMTEMP_SAMPLING_US_MAX)
+			return -EINVAL;
+		cfg->sampling_us = (u32)uval;
+		*set |= SIMTEMP_CFG_SAMPLING;
+	} else if (!strcmp(key, "speed")) {
+		if (uval < SIMTEMP_SPEED_MIN || uval > SIMTEMP_SPEED_MAX)
+			return -EINVAL;
+		cfg->speed = (u32)uval;
+		*set |= SIMTEMP_CFG_SPEED;
+	} else if (!strcmp(key, "hysteresis_mc")) {
+		if (uval > SIMTEMP_HYSTERESIS_MC_MAX)
+			return -EINVAL;
+		cfg->hysteresis_mc = (u32)uval;
+		*set |= SIMTEMP_CFG_HYSTERESIS;
+	} else if (!strcmp(key, "rate_mc_per_s")) {
+		if (uval > SIMTEMP_RATE_MC_S_MAX)
+			return -EINVAL;
+		cfg->rate_mc_per_s = (u32)uval;
+		*set |= SIMTEMP_CFG_RATE;
+	} else if (!strcmp(key, "agg_window_ms")) {
+		if (uval && (uval < SIMTEMP_AGG_WINDOW_MS_MIN || uval > SIMTEMP_AGG_WINDOW_MS_MAX))
+			return -EINVAL;
+		cfg->agg_window_ms = (u32)uval;
+		*set |= SIMTEMP_CFG_AGG_WINDOW;
+	} else {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/*
+ * Takes whitespace-separated key=value pairs (sampling_ms, sampling_us,
+ * threshold_mc, mode, speed, hysteresis_mc, rate_mc_per_s, agg_window_ms).
+ * Every pair is validated first; the given parameters are then written in
+ * one seqlock write section, so the producer sees either the old or the new
+ * configuration, never a mix. Parameters not given keep their value; on any
+ * error nothing is applied.
+ */
+static ssize_t config_store(struct device *dev,
+                            struct device_attribute *attr,
+                            const char *buf, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(dev);
+	struct simtemp_config cfg = { 0 };
+	char *args, *cur, *tok, *val;
+	unsigned int set = 0;
+	int ret = 0;
+
+	if (!simtemp) return -ENODEV;
+
+	args = kstrndup(buf, count, GFP_KERNEL);
+	if (!args)
+		return -ENOMEM;
+
+	cur = args;
+	while ((tok = strsep(&cur, " \t\n")) != NULL) {
+		if (!*tok)
+			continue;
+		val = strchr(tok, '=');
+		if (!val) {
+			ret = -EINVAL;
+			break;
+		}
+		*val++ = '\0';
+		ret = simtemp_config_parse(simtemp, tok, val, &cfg, &set);
+		if (ret)
+			break;
+	}
+
+	if (ret) {
+		pr_warn("simtemp: Invalid config '%s' (%d), nothing applied\n", tok, ret);
+		goto out;
+	}
+
+	/* Only the given fields, in one write section: a concurrent single-attribute store is not undone */
+	ret = simtemp_config_commit(simtemp, &cfg, set);
+	debug_dbg("config set (fields 0x%x)\n", set);
+out:
+	kfree(args);
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(config);
+
+/* --- profile attribute (binary, write-only) --- */
+static ssize_t profile_write(struct file *filp, struct kobject *kobj,
+                             struct bin_attribute *attr, char *buf,
+                             loff_t off, size_t count)
+{
+    struct simtemp_dev *simtemp = dev_get_drvdata(kobj_to_dev(kobj));
+
+	if (!simtemp) return -ENODEV;
+
+	return nxp_simtemp_profile_write(simtemp, buf, off, count);
+}
+
+static BIN_ATTR_WO(profile, sizeof(struct simtemp_profile_hdr) +
+                            SIMTEMP_PROFILE_POINTS_MAX * sizeof(struct simtemp_profile_point));
 
 /* --- Attribute Group --- */
 static struct attribute *simtemp_attrs[] = {
     &dev_attr_sampling_ms.attr,
+    &dev_attr_sampling_us.attr,
+    &dev_attr_speed.attr,
     &dev_attr_threshold_mc.attr,
+    &dev_attr_hysteresis_mc.attr,
+    &dev_attr_rate_mc_per_s.attr,
+    &dev_attr_agg_window_ms.attr,
+    &dev_attr_cpu.attr,
     &dev_attr_mode.attr,
     &dev_attr_stats.attr,
+    &dev_attr_config.attr,
+    NULL,
+};
+
+static struct bin_attribute *simtemp_bin_attrs[] = {
+    &bin_attr_profile,
     NULL,
 };
 
 static struct attribute_group simtemp_attr_group = {
     .attrs = simtemp_attrs,
+    .bin_attrs = simtemp_bin_attrs,
 };
 
 /**
@@ -0,0 +1,104 @@
+/**
+ * @file    nxp_simtemp_trace.h
+ * @author  Omar Mendiola
+ * @brief   Tracepoints of the NXP simtemp driver.
+ * Hot-path events under the nxp_simtemp trace system. When disabled a
+ * tracepoint is a patched-out branch, so they can stay in the sampling and
+ * read paths where printk would be too expensive. Enable with e.g.
+ * "echo 1 > /sys/kernel/tracing/events/nxp_simtemp/enable".
+ * CREATE_TRACE_POINTS is defined by nxp_simtemp_simulator.c only.
+ * @version 0.1
+ * @date    2025-10-24
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM nxp_simtemp
+
+#if !defined(NXP_SIMTEMP_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define NXP_SIMTEMP_TRACE_H_
+
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+
+/**
+ * @brief A sample was generated and queued by the producer.
+ */
+TRACE_EVENT(sample_generated,
+	TP_PROTO(int id, u64 seq, u64 timestamp_ns, s32 temp_mc, u32 flags),
+	TP_ARGS(id, seq, timestamp_ns, temp_mc, flags),
+
+	TP_STRUCT__entry(
+		__field(int, id)
+		__field(u64, seq)
+		__field(u64, timestamp_ns)
+		__field(s32, temp_mc)
+		__field(u32, flags)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->seq = seq;
+		__entry->timestamp_ns = timestamp_ns;
+		__entry->temp_mc = temp_mc;
+		__entry->flags = flags;
+	),
+
+	TP_printk("simtemp%d seq=%llu ts=%llu temp_mc=%d flags=0x%x",
+	          __entry->id, __entry->seq, __entry->timestamp_ns,
+	          __entry->temp_mc, __entry->flags)
+);
+
+/**
+ * @brief A read() returned samples to userspace.
+ */
+TRACE_EVENT(read_served,
+	TP_PROTO(int id, size_t samples, u64 next_seq),
+	TP_ARGS(id, samples, next_seq),
+
+	TP_STRUCT__entry(
+		__field(int, id)
+		__field(size_t, samples)
+		__field(u64, next_seq)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->samples = samples;
+		__entry->next_seq = next_seq;
+	),
+
+	TP_printk("simtemp%d samples=%zu next_seq=%llu",
+	          __entry->id, __entry->samples, __entry->next_seq)
+);
+
+/**
+ * @brief The producer woke the sleeping readers and pollers of an instance.
+ */
+TRACE_EVENT(poll_wakeup,
+	TP_PROTO(int id, u64 producer),
+	TP_ARGS(id, producer),
+
+	TP_STRUCT__entry(
+		__field(int, id)
+		__field(u64, producer)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->producer = producer;
+	),
+
+	TP_printk("simtemp%d producer=%llu", __entry->id, __entry->producer)
+);
+
+#endif /* NXP_SIMTEMP_TRACE_H_ */
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE nxp_simtemp_trace
+#include <trace/define_trace.h>
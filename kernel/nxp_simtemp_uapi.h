@@ -0,0 +1,242 @@
+/**
+ * @file    nxp_simtemp_uapi.h
+ * @author  Omar Mendiola
+ * @brief   Userspace ABI of the NXP simtemp driver.
+ * Binary sample record, flags, ioctls and the layout of the mmap()-able
+ * sample ring. Only depends on <linux/types.h> and <linux/ioctl.h> so it
+ * can be included by both the driver and userspace clients.
+ * @version 0.1
+ * @date    2025-10-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef NXP_SIMTEMP_UAPI_H_
+#define NXP_SIMTEMP_UAPI_H_
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/* --- Flags for simtemp_sample --- */
+#define SIMTEMP_SAMPLE_FLAG_NEW             (1 << 0) /* Indicates a fresh sample */
+#define SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI    (1 << 1) /* Threshold alert active (see hysteresis_mc) */
+#define SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE    (1 << 2) /* Generated value clamped to the valid range */
+#define SIMTEMP_SAMPLE_FLAG_RATE_HI         (1 << 3) /* |dT/dt| above rate_mc_per_s */
+#define SIMTEMP_SAMPLE_FLAG_ALERT_EDGE      (1 << 4) /* THRESHOLD_HI or RATE_HI changed at this sample */
+#define SIMTEMP_SAMPLE_FLAG_GAP             (1 << 5) /* First sample after sampling was stopped (lazy mode) */
+
+/*
+ * GAP marks the first sample generated after an idle period of the lazy
+ * module parameter: nothing was sampled between the previous sample and
+ * this one, whose timestamp is the resume time.
+ *
+ * THRESHOLD_HI and RATE_HI are alert states, set on every sample while the
+ * alert is active. The threshold alert raises when temp_mc goes above
+ * threshold_mc and clears once temp_mc is at or below threshold_mc -
+ * hysteresis_mc. The rate alert compares the change from the previous
+ * sample, in mC per second of sample time, with rate_mc_per_s (0 = off).
+ * POLLPRI is edge-triggered: it is reported after any sample flagged
+ * ALERT_EDGE, not while an alert stays active, until the file consumes it
+ * with a read() that returns data or with SIMTEMP_IOC_ACK_ALERT.
+ */
+
+/**
+ * @brief Structure for a single temperature sample (binary record).
+ */
+struct simtemp_sample {
+	__u64 timestamp_ns;   /* Monotonic timestamp in nanoseconds */
+	__s32 temp_mc;        /* Temperature in milli-Celsius */
+	__u32 flags;          /* Status flags (e.g., new, threshold) */
+} __attribute__((packed)); /* Ensure no padding */
+
+/* --- read() stream formats (SIMTEMP_IOC_SET_FORMAT) --- */
+
+/*
+ * SIMTEMP_FORMAT_RAW (default): read() returns whole struct simtemp_sample
+ * records.
+ *
+ * SIMTEMP_FORMAT_DELTA_V1: every read() returns one self-contained frame,
+ * a struct simtemp_frame_hdr followed by hdr.payload_size bytes holding
+ * hdr.count - 1 delta records. The header carries the first sample of the
+ * frame; each record encodes a sample relative to the previous one as
+ * unsigned LEB128 varints:
+ *  1. zigzag(dt - prev_dt), dt being the timestamp delta in ns and prev_dt
+ *     the one of the previous record (0 for the first record)
+ *  2. (zigzag(temp_mc delta) << 1) | flags_changed
+ *  3. flags, only present if flags_changed
+ * zigzag(v) = (v << 1) ^ (v >> 63). A record takes at most
+ * SIMTEMP_DELTA_RECORD_MAX bytes; periodic samples typically take 4-6.
+ */
+#define SIMTEMP_FORMAT_RAW          0
+#define SIMTEMP_FORMAT_DELTA_V1     1
+#define SIMTEMP_FORMAT_AGG_V1       2
+
+#define SIMTEMP_FRAME_MAGIC         0x5354 /* "ST" */
+#define SIMTEMP_DELTA_RECORD_MAX    20     /* 10 + 5 + 5 bytes of varints */
+
+/**
+ * @brief Header of a SIMTEMP_FORMAT_DELTA_V1 frame.
+ * Parsers skip hdr_size bytes, so later versions may append fields.
+ */
+struct simtemp_frame_hdr {
+	__u16 magic;              /* SIMTEMP_FRAME_MAGIC */
+	__u8  version;            /* SIMTEMP_FORMAT_DELTA_V1 */
+	__u8  hdr_size;           /* sizeof(struct simtemp_frame_hdr) */
+	__u16 count;              /* Samples in the frame, including the base sample */
+	__u16 payload_size;       /* Bytes of delta records after the header */
+	__u64 base_timestamp_ns;  /* First sample of the frame */
+	__s32 base_temp_mc;
+	__u32 base_flags;
+};
+
+/*
+ * SIMTEMP_FORMAT_AGG_V1: read() returns whole struct simtemp_agg_record
+ * records, one per closed aggregation window of the instance (sysfs
+ * agg_window_ms, 0 = no records). Windows are aligned on multiples of the
+ * window length on the sample clock; a window closes when the first sample
+ * of a later window is generated. Switching a file to this format starts
+ * at the next closed window; the file is readable once a record is pending.
+ */
+
+/**
+ * @brief Summary of the samples of one aggregation window.
+ */
+struct simtemp_agg_record {
+	__u64 start_ns;           /* Window start, same clock as timestamp_ns */
+	__u32 window_us;          /* Window length */
+	__u32 count;              /* Samples in the window */
+	__s32 min_mc;
+	__s32 max_mc;
+	__s32 mean_mc;            /* Rounded toward zero */
+	__u32 flags;              /* OR of the flags of the samples */
+};
+
+/* --- Profile tables (sysfs "profile" binary attribute) --- */
+
+/*
+ * A profile table is a struct simtemp_profile_hdr followed by hdr.count
+ * struct simtemp_profile_point. Point i is reached dt_us after point i - 1;
+ * the dt_us of point 0 is the time from the last point back to point 0 when
+ * the replay loops. Mode "profile" replays the table in a loop with linear
+ * interpolation between points; dt_us = 0 makes a step.
+ */
+#define SIMTEMP_PROFILE_MAGIC       0x46505453 /* "STPF" */
+
+struct simtemp_profile_hdr {
+	__u32 magic;              /* SIMTEMP_PROFILE_MAGIC */
+	__u32 count;              /* Points after the header */
+};
+
+struct simtemp_profile_point {
+	__u32 dt_us;              /* Time from the previous point, in microseconds */
+	__s32 temp_mc;            /* Temperature at this point, in milli-Celsius */
+};
+
+/* --- mmap() interface --- */
+
+/*
+ * mmap() offsets (bytes). A client maps both regions of the same file:
+ *  - SIMTEMP_MMAP_OFF_RING:   device-wide sample ring, read-only. Starts with
+ *                             struct simtemp_ring_hdr; records follow at
+ *                             hdr->data_offset.
+ *  - SIMTEMP_MMAP_OFF_CURSOR: one page, read-write, private to the open file.
+ *                             Holds struct simtemp_ring_cursor.
+ */
+#define SIMTEMP_MMAP_OFF_RING       0x00000000ULL
+#define SIMTEMP_MMAP_OFF_CURSOR     0x10000000ULL
+
+#define SIMTEMP_RING_MAGIC          0x534d5452 /* "SMTR" */
+#define SIMTEMP_RING_VERSION        1
+
+/**
+ * @brief Header at the start of the mmap()ed sample ring.
+ *
+ * The sample with sequence number seq lives in record[seq % slots] and is
+ * valid while producer - seq <= capacity. The kernel writes the record and
+ * then publishes producer with release semantics. To consume seq, load
+ * producer (acquire), copy the record, issue a read barrier and reload
+ * producer: if producer - seq > capacity the copy may be torn and the
+ * sample counts as dropped.
+ */
+struct simtemp_ring_hdr {
+	__u32 magic;          /* SIMTEMP_RING_MAGIC */
+	__u16 version;        /* SIMTEMP_RING_VERSION */
+	__u16 record_size;    /* sizeof(struct simtemp_sample) */
+	__u32 slots;          /* Number of record slots in the ring */
+	__u32 capacity;       /* Samples kept before overwrite (slots - 1) */
+	__u32 data_offset;    /* Byte offset of record[0] from the mapping start */
+	__u32 reserved;
+	__u64 producer;       /* Sequence number of the next sample to be written */
+};
+
+/**
+ * @brief Per-file consumer cursor (SIMTEMP_MMAP_OFF_CURSOR page).
+ *
+ * Shared between read() and mmap() consumers of the same file: read()
+ * advances it, and an mmap() client stores here the sequence number of the
+ * next sample it wants so poll() only reports POLLIN when it has work.
+ */
+struct simtemp_ring_cursor {
+	__u64 consumer;       /* Sequence number of the next sample to consume */
+};
+
+/* --- ioctl() interface --- */
+
+#define SIMTEMP_IOC_MAGIC           's'
+
+/**
+ * @brief Argument of SIMTEMP_IOC_READ_BATCH.
+ *
+ * Copies, oldest first, up to max buffered samples whose timestamp_ns is
+ * greater than since_timestamp_ns (0 returns every buffered sample) and
+ * stores how many were copied in count. Never blocks. Unlike read(), the
+ * query is not limited to the samples produced after open(): a collector
+ * that reconnects passes the timestamp of the last sample it stored and
+ * fetches the gap in one call. The read() cursor of the file then moves
+ * past the last sample returned, so read() continues from there. If count
+ * equals max, more samples may be pending: repeat with the timestamp of the
+ * last sample returned.
+ */
+struct simtemp_read_batch {
+	__u64 buf;                /* in:  user address of struct simtemp_sample[max] */
+	__u64 since_timestamp_ns; /* in:  only samples newer than this */
+	__u32 max;                /* in:  capacity of buf, in samples */
+	__u32 count;              /* out: samples stored in buf */
+	__u32 flags;              /* in:  must be 0 */
+	__u32 reserved;           /* must be 0 */
+};
+
+#define SIMTEMP_IOC_READ_BATCH      _IOWR(SIMTEMP_IOC_MAGIC, 1, struct simtemp_read_batch)
+
+/*
+ * Selects the read() stream format of the file (SIMTEMP_FORMAT_*).
+ * Fails with -EINVAL for formats the driver does not know, so clients can
+ * fall back to SIMTEMP_FORMAT_RAW. SIMTEMP_IOC_READ_BATCH and mmap() always
+ * use raw records.
+ */
+#define SIMTEMP_IOC_SET_FORMAT      _IOW(SIMTEMP_IOC_MAGIC, 2, __u32)
+
+/**
+ * @brief Argument of SIMTEMP_IOC_SET_WATERMARK.
+ *
+ * A file becomes readable (POLLIN, blocking read() returns) once at least
+ * samples records are pending, or once the oldest pending sample is older
+ * than max_latency_us. Non-blocking read() still returns whatever is
+ * pending. The defaults, samples = 1 and max_latency_us = 0 (no deadline),
+ * wake the reader on every sample. samples must be 1..ring capacity.
+ */
+struct simtemp_watermark {
+	__u32 samples;            /* Low watermark, in samples */
+	__u32 max_latency_us;     /* Deadline for the oldest pending sample; 0 = none */
+};
+
+#define SIMTEMP_IOC_SET_WATERMARK   _IOW(SIMTEMP_IOC_MAGIC, 3, struct simtemp_watermark)
+
+/*
+ * Consumes the pending POLLPRI of the file without reading, for clients
+ * that drain the mmap()ed ring. A read() that returns data does the same.
+ */
+#define SIMTEMP_IOC_ACK_ALERT       _IO(SIMTEMP_IOC_MAGIC, 4)
+
+#endif /* NXP_SIMTEMP_UAPI_H_ */
@@ -2,8 +2,13 @@
  * @file    simtemp_debug.h
  * @author  Omar Mendiola
  * @brief   Debugging helper macros for the simtemp driver.
- * @version 0.2
- * @date    2025-10-17
+ * Compiled out unless the module is built with SIMTEMP_DEBUG=1
+ * ("make SIMTEMP_DEBUG=1", passed to the compiler by the Makefile). A debug
+ * build can still be silenced at runtime with the "debug" module parameter.
+ * When compiled out the macros only type-check their arguments.
+ * Hot-path events are covered by the tracepoints of nxp_simtemp_trace.h.
+ * @version 0.3
+ * @date    2025-10-24
  *
  * @copyright Copyright (c) 2025
  *
@@ -14,56 +19,65 @@
 
 /* Includes needed for the macros */
 #include <linux/printk.h>
-#include <linux/delay.h>
+#include <linux/compiler.h>
 
 /* --- Debug Control --- */
 #define SIMTEMP_DEBUG_ENABLED 1
 #define SIMTEMP_DEBUG_DISABLED 0
-#define SIMTEMP_DEBUG_DELAY_MS 50
 
-/* Set to 1 to enable debug messages and delays, 0 to disable */
-#define SIMTEMP_DEBUG SIMTEMP_DEBUG_ENABLED
+/* Selected at build time (Makefile: SIMTEMP_DEBUG ?= 0) */
+#ifndef SIMTEMP_DEBUG
+#define SIMTEMP_DEBUG SIMTEMP_DEBUG_DISABLED
+#endif
+
+#if SIMTEMP_DEBUG == SIMTEMP_DEBUG_ENABLED
+/* "debug" module parameter, defined in nxp_simtemp_main.c */
+extern bool simtemp_debug;
+#define simtemp_debug_on() READ_ONCE(simtemp_debug)
+#else
+#define simtemp_debug_on() false
+#endif
 
 /* --- Debug Macros --- */
 
 /**
- * @brief Prints an emergency message and adds a delay if SIMTEMP_DEBUG is enabled.
- * Useful for ensuring a message gets flushed before a potential crash.
+ * @brief Prints a lifecycle debug message (probe/remove/exit steps).
+ * Used to be followed by a delay to flush the console; it no longer sleeps,
+ * so it is safe on any path.
  * @param fmt Format string.
  * @param ... Variable arguments for the format string.
  */
 #define debug_pr_delay(fmt, ...) \
 	do { \
-		if (SIMTEMP_DEBUG == SIMTEMP_DEBUG_ENABLED) { \
-			pr_emerg("SIMTEMP_DBG: " fmt, ##__VA_ARGS__); \
-			msleep(SIMTEMP_DEBUG_DELAY_MS); \
+		if (simtemp_debug_on()) { \
+			pr_info("SIMTEMP_DBG: " fmt, ##__VA_ARGS__); \
 		} \
 	} while (0)
 
 /**
- * @brief Prints a debug message with the address of a pointer if SIMTEMP_DEBUG is enabled.
+ * @brief Prints a debug message with the address of a pointer if debugging is enabled.
  * @param msg Descriptive message string.
  * @param ptr Pointer whose address is to be printed.
  */
 #define debug_pr_addr(msg, ptr) \
 	do { \
-		if (SIMTEMP_DEBUG == SIMTEMP_DEBUG_ENABLED) { \
+		if (simtemp_debug_on()) { \
 			pr_info("SIMTEMP_DBG: %s at %p\n", (msg), (ptr)); \
 		} \
 	} while (0)
 
 /**
  * @brief Standard debug message print macro.
- * Only prints if SIMTEMP_DEBUG is enabled.
+ * Only prints if debugging is compiled in and enabled.
  * @param fmt Format string.
  * @param ... Variable arguments for the format string.
  */
 #define debug_dbg(fmt, ...) \
     do { \
-        if (SIMTEMP_DEBUG == SIMTEMP_DEBUG_ENABLED) { \
+        if (simtemp_debug_on()) { \
             pr_info("SIMTEMP_DBG: " fmt, ##__VA_ARGS__); \
         } \
     } while (0)
 
 
-#endif /* SIMTEMP_DEBUG_H_ */
\ No newline at end of file
+#endif /* SIMTEMP_DEBUG_H_ */
@@ -1,6 +1,6 @@
 #!/bin/bash
 #
-# build.sh: Builds the kernel module.
+# build.sh: Builds the kernel module and the C++ client library.
 #
 # This script automatically detects the correct path for kernel headers,
 # supporting both standard Linux distributions and the WSL2 environment.
@@ -18,6 +18,7 @@ SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
 # Assume the project root is one directory above the script directory.
 PROJECT_ROOT=$(dirname "${SCRIPT_DIR}")
 KERNEL_MODULE_DIR="${PROJECT_ROOT}/kernel"
+LIBSIMTEMP_DIR="${PROJECT_ROOT}/user/libsimtemp"
 
 # --- Kernel Source/Header Detection ---
 KERNEL_VERSION=$(uname -r)
@@ -73,10 +74,16 @@ MODULE_NAME="nxp_simtemp"
 echo "INFO: Building kernel module '${MODULE_NAME}.ko'..."
 # -C: Change to the kernel source directory.
 # M=: Specifies the location of our kernel module's source and Makefile.
-make -C "${KERNEL_DIR}" M="${KERNEL_MODULE_DIR}" modules
+# SIMTEMP_DEBUG=1 in the environment compiles in the debug messages.
+make -C "${KERNEL_DIR}" M="${KERNEL_MODULE_DIR}" SIMTEMP_DEBUG="${SIMTEMP_DEBUG:-0}" modules
 
 echo "INFO: Kernel module built successfully."
+
+# --- C++ Client Library ---
+echo "INFO: Building libsimtemp and simtemp_bench..."
+make -C "${LIBSIMTEMP_DIR}"
+
 echo ""
-echo "Build complete. The user-space application is a Python script and does not need compilation."
+echo "Build complete. The Python CLI needs no compilation; the benchmark is ${LIBSIMTEMP_DIR}/build/simtemp_bench."
 echo "You can now run the demo with 'scripts/run_demo.sh'."
 
@@ -32,8 +32,8 @@ MODULE_NAME="nxp_simtemp"
 MODULE_FILE="${PROJECT_ROOT}/kernel/${MODULE_NAME}.ko"
 USER_APP_CLI="${PROJECT_ROOT}/user/cli/main.py"
 # Device entries created by the driver
-DEV_ENTRY="/dev/simtemp"
-SYSFS_PATH="/sys/class/misc/simtemp"
+DEV_ENTRY="/dev/simtemp0"
+SYSFS_PATH="/sys/class/misc/simtemp0"
 
 # --- Pre-flight Checks ---
 if [ "$(id -u)" -ne 0 ]; then
@@ -71,6 +71,13 @@ cleanup() {
 trap cleanup EXIT
 
 # --- Demo Execution ---
+# insmod does not resolve dependencies: load the modules the .ko links
+# against first (industrialio, kfifo_buf and hwmon on kernels that build
+# the IIO and hwmon frameworks as modules; built-in ones are a no-op)
+for dep in $(modinfo -F depends "${MODULE_FILE}" | tr ',' ' '); do
+    echo "INFO: Loading dependency '${dep}'..."
+    modprobe "${dep}"
+done
 echo "INFO: Loading module '${MODULE_NAME}'..."
 insmod "${MODULE_FILE}"
 
@@ -23,8 +23,8 @@ PROJECT_ROOT=$(dirname "${SCRIPT_DIR}")
 MODULE_NAME="nxp_simtemp"
 MODULE_FILE="${PROJECT_ROOT}/kernel/${MODULE_NAME}.ko"
 USER_TEST_SCRIPT="${PROJECT_ROOT}/user/cli/test_mode.py"
-DEV_ENTRY="/dev/simtemp"
-SYSFS_PATH="/sys/class/misc/simtemp"
+DEV_ENTRY="/dev/simtemp0"
+SYSFS_PATH="/sys/class/misc/simtemp0"
 
 # --- Pre-flight Checks ---
 if [ "$(id -u)" -ne 0 ]; then
@@ -91,6 +91,13 @@ if lsmod | grep -q "^${MODULE_NAME}"; then
     sleep 1 # Give it a second
 fi
 
+# insmod does not resolve dependencies: load the modules the .ko links
+# against first (industrialio, kfifo_buf and hwmon on kernels that build
+# the IIO and hwmon frameworks as modules; built-in ones are a no-op)
+for dep in $(modinfo -F depends "${MODULE_FILE}" | tr ',' ' '); do
+    echo "INFO: Loading dependency '${dep}'..."
+    modprobe "${dep}"
+done
 echo "INFO: Loading module '${MODULE_FILE}'..."
 insmod "${MODULE_FILE}"
 
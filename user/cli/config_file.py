@@ -5,17 +5,38 @@ import os # Used to build paths dynamically
 import zoneinfo #python3.9+ for timezone handling
 
 # Base paths (adjust if your misc device name or class path differs)
-# Note: The actual device name might be dynamic (e.g., /dev/simtemp-nxp_simtemp.0)
-#       Adjust DRIVER_DEV_PATH or use glob in the main app if needed.
-DRIVER_BASE_NAME = "simtemp" # Assumes the simple name or a symlink
+# Note: Every instance gets its own node, /dev/simtemp0 .. /dev/simtemp<N-1>
+#       (module parameter "instances"). The CLI drives instance 0.
+DRIVER_BASE_NAME = "simtemp0"
 DRIVER_DEV_PATH = f"/dev/{DRIVER_BASE_NAME}"
 DRIVER_SYSFS_PATH = f"/sys/class/misc/{DRIVER_BASE_NAME}"
+DRIVER_DEV_GLOB = "/dev/simtemp[0-9]*" # All instances
+DRIVER_SYSFS_CLASS_PATH = "/sys/class/misc"
 
 # Sysfs attribute paths
 SAMPLING_MS_PATH = os.path.join(DRIVER_SYSFS_PATH, "sampling_ms")
+SAMPLING_US_PATH = os.path.join(DRIVER_SYSFS_PATH, "sampling_us")
+SPEED_PATH = os.path.join(DRIVER_SYSFS_PATH, "speed")
 THRESHOLD_MC_PATH = os.path.join(DRIVER_SYSFS_PATH, "threshold_mc")
+HYSTERESIS_MC_PATH = os.path.join(DRIVER_SYSFS_PATH, "hysteresis_mc")
+RATE_MC_PER_S_PATH = os.path.join(DRIVER_SYSFS_PATH, "rate_mc_per_s")
+AGG_WINDOW_MS_PATH = os.path.join(DRIVER_SYSFS_PATH, "agg_window_ms")
+CPU_PATH = os.path.join(DRIVER_SYSFS_PATH, "cpu")
 MODE_PATH = os.path.join(DRIVER_SYSFS_PATH, "mode")
 STATS_PATH = os.path.join(DRIVER_SYSFS_PATH, "stats")
+CONFIG_PATH = os.path.join(DRIVER_SYSFS_PATH, "config")
+PROFILE_PATH = os.path.join(DRIVER_SYSFS_PATH, "profile")
+
+# Module parameters
+LAZY_PARAM_PATH = "/sys/module/nxp_simtemp/parameters/lazy"
+
+# Standard framework views of the same instance (kernels with hwmon / IIO)
+HWMON_CLASS_PATH = "/sys/class/hwmon"
+HWMON_NAME = "simtemp"
+IIO_DEVICES_PATH = "/sys/bus/iio/devices"
+# IIO buffered scan with in_temp and in_timestamp enabled: s32 temp_mc, 4 pad bytes, s64 timestamp
+IIO_SCAN_FORMAT: str = "=i4xq"
+IIO_SCAN_SIZE: int = 16
 
 # Test result codes
 TEST_FAIL_CODE: int = -1
@@ -25,11 +46,48 @@ TEST_PASS_CODE: int = 0
 # Corresponds to: __u64 timestamp_ns; __s32 temp_mc; __u32 flags;
 SAMPLE_FORMAT: str = "<QiI"
 SAMPLE_SIZE_BYTES: int = 16 # 8 + 4 + 4
+# Samples requested per read(); the driver returns all queued samples that fit
+READ_BATCH_SAMPLES: int = 64
+
+# ioctl interface (mirroring kernel/nxp_simtemp_uapi.h)
+# struct simtemp_read_batch: __u64 buf; __u64 since_timestamp_ns; __u32 max, count, flags, reserved
+READ_BATCH_ARGS_FORMAT: str = "<QQIIII"
+READ_BATCH_ARGS_SIZE: int = 32
+# _IOWR('s', 1, struct simtemp_read_batch)
+SIMTEMP_IOC_READ_BATCH: int = (3 << 30) | (READ_BATCH_ARGS_SIZE << 16) | (ord('s') << 8) | 1
+
+# _IOW('s', 2, __u32): selects the read() stream format of a file
+SIMTEMP_IOC_SET_FORMAT: int = (1 << 30) | (4 << 16) | (ord('s') << 8) | 2
+# _IOW('s', 3, struct simtemp_watermark): __u32 samples; __u32 max_latency_us
+SIMTEMP_IOC_SET_WATERMARK: int = (1 << 30) | (8 << 16) | (ord('s') << 8) | 3
+WATERMARK_ARGS_FORMAT: str = "<II"
+# _IO('s', 4): consumes the pending POLLPRI of a file without reading
+SIMTEMP_IOC_ACK_ALERT: int = (ord('s') << 8) | 4
+SIMTEMP_FORMAT_RAW: int = 0
+SIMTEMP_FORMAT_DELTA_V1: int = 1
+SIMTEMP_FORMAT_AGG_V1: int = 2
+# struct simtemp_agg_record: __u64 start_ns; __u32 window_us, count; __s32 min, max, mean; __u32 flags
+AGG_RECORD_FORMAT: str = "<QIIiiiI"
+AGG_RECORD_SIZE: int = 32
+# struct simtemp_frame_hdr: magic, version, hdr_size, count, payload_size, base sample
+FRAME_HDR_FORMAT: str = "<HBBHHQiI"
+FRAME_HDR_SIZE: int = 24
+SIMTEMP_FRAME_MAGIC: int = 0x5354
+
+# Profile table ("profile" sysfs attribute): struct simtemp_profile_hdr
+# (__u32 magic; __u32 count) followed by count struct simtemp_profile_point
+# (__u32 dt_us; __s32 temp_mc)
+PROFILE_HDR_FORMAT: str = "<II"
+PROFILE_POINT_FORMAT: str = "<Ii"
+SIMTEMP_PROFILE_MAGIC: int = 0x46505453
 
-# Driver flags (mirroring kernel/nxp_simtemp.h)
+# Driver flags (mirroring kernel/nxp_simtemp_uapi.h)
 SIMTEMP_SAMPLE_FLAG_NEW: int = (1 << 0)
-SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI: int = (1 << 1)
-# Add other flags here if defined in the driver
+SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI: int = (1 << 1) # Threshold alert active (with hysteresis)
+SIMTEMP_SAMPLE_FLAG_OUT_OF_RANGE: int = (1 << 2)
+SIMTEMP_SAMPLE_FLAG_RATE_HI: int = (1 << 3)      # |dT/dt| above rate_mc_per_s
+SIMTEMP_SAMPLE_FLAG_ALERT_EDGE: int = (1 << 4)   # An alert raised or cleared at this sample (POLLPRI)
+SIMTEMP_SAMPLE_FLAG_GAP: int = (1 << 5)          # First sample after an idle period (lazy=1)
 
 # Timezone for displaying timestamps (UTC-6)
 DISPLAY_TIMEZONE = zoneinfo.ZoneInfo("America/Mexico_City")
\ No newline at end of file
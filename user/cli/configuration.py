@@ -1,9 +1,12 @@
 # configuration.py
 """Provides functions to read/write simtemp driver sysfs configuration."""
 
+import os
+import struct
 import typing
 from config_file import (
-    SAMPLING_MS_PATH, THRESHOLD_MC_PATH, MODE_PATH, STATS_PATH
+    SAMPLING_MS_PATH, SAMPLING_US_PATH, SPEED_PATH, THRESHOLD_MC_PATH, HYSTERESIS_MC_PATH, RATE_MC_PER_S_PATH, AGG_WINDOW_MS_PATH, CPU_PATH, MODE_PATH, STATS_PATH, CONFIG_PATH,
+    PROFILE_PATH, PROFILE_HDR_FORMAT, PROFILE_POINT_FORMAT, SIMTEMP_PROFILE_MAGIC
 )
 
 def set_config_value(path: str, value: str) -> bool:
@@ -71,6 +74,60 @@ def get_sampling_ms() -> typing.Optional[int]:
             return None
     return None
 
+def set_sampling_us(period: int) -> bool:
+    """Sets the sampling period in microseconds (high-resolution timer).
+
+    Args:
+        period: The desired sampling period (integer).
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting sampling_us to {period}...")
+    return set_config_value(SAMPLING_US_PATH, str(period))
+
+def get_sampling_us() -> typing.Optional[int]:
+    """Gets the current sampling period in microseconds.
+
+    Returns:
+        The sampling period as an integer, or None on error.
+    """
+    value_str = get_config_value(SAMPLING_US_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse sampling_us value '{value_str}' as integer.")
+            return None
+    return None
+
+def set_speed(speed: int) -> bool:
+    """Sets the fast-replay speed (virtual clock rate, 1 = real time).
+
+    Args:
+        speed: Speed factor (integer).
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting speed to {speed}...")
+    return set_config_value(SPEED_PATH, str(speed))
+
+def get_speed() -> typing.Optional[int]:
+    """Gets the current fast-replay speed.
+
+    Returns:
+        The speed factor as an integer, or None on error.
+    """
+    value_str = get_config_value(SPEED_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse speed value '{value_str}' as integer.")
+            return None
+    return None
+
 def set_threshold_mc(threshold: int) -> bool:
     """Sets the alert threshold in milli-degrees Celsius.
 
@@ -98,22 +155,161 @@ def get_threshold_mc() -> typing.Optional[int]:
             return None
     return None
 
+def set_hysteresis_mc(hysteresis: int) -> bool:
+    """Sets the hysteresis band below the threshold (milli-Celsius).
+
+    An active threshold alert only clears once the temperature is at or
+    below threshold_mc - hysteresis_mc.
+
+    Args:
+        hysteresis: Band width in mC (integer, >= 0).
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting hysteresis to {hysteresis} mC...")
+    return set_config_value(HYSTERESIS_MC_PATH, str(hysteresis))
+
+def get_hysteresis_mc() -> typing.Optional[int]:
+    """Gets the current hysteresis band.
+
+    Returns:
+        The hysteresis in mC as an integer, or None on error.
+    """
+    value_str = get_config_value(HYSTERESIS_MC_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse hysteresis value '{value_str}' as integer.")
+            return None
+    return None
+
+def set_rate_mc_per_s(rate: int) -> bool:
+    """Sets the rate-of-change alert limit (mC per second, 0 disables it).
+
+    Args:
+        rate: Limit in mC/s (integer, >= 0).
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting rate limit to {rate} mC/s...")
+    return set_config_value(RATE_MC_PER_S_PATH, str(rate))
+
+def get_rate_mc_per_s() -> typing.Optional[int]:
+    """Gets the current rate-of-change alert limit.
+
+    Returns:
+        The limit in mC/s as an integer, or None on error.
+    """
+    value_str = get_config_value(RATE_MC_PER_S_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse rate value '{value_str}' as integer.")
+            return None
+    return None
+
+def set_agg_window_ms(window: int) -> bool:
+    """Sets the aggregation window of the SIMTEMP_FORMAT_AGG_V1 records.
+
+    Args:
+        window: Window length in ms (integer, 0 = off).
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting aggregation window to {window} ms...")
+    return set_config_value(AGG_WINDOW_MS_PATH, str(window))
+
+def get_agg_window_ms() -> typing.Optional[int]:
+    """Gets the current aggregation window.
+
+    Returns:
+        The window in ms as an integer (0 = off), or None on error.
+    """
+    value_str = get_config_value(AGG_WINDOW_MS_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse agg_window_ms value '{value_str}' as integer.")
+            return None
+    return None
+
+def set_cpu(cpu: int) -> bool:
+    """Pins the sampling timer to a CPU.
+
+    Args:
+        cpu: Online CPU number, or -1 to unpin.
+
+    Returns:
+        True on success, False on failure.
+    """
+    print(f"Setting sampling CPU to {cpu}...")
+    return set_config_value(CPU_PATH, str(cpu))
+
+def get_cpu() -> typing.Optional[int]:
+    """Gets the sampling CPU.
+
+    Returns:
+        The CPU number (-1 = unbound), or None on error.
+    """
+    value_str = get_config_value(CPU_PATH)
+    if value_str is not None:
+        try:
+            return int(value_str)
+        except ValueError:
+            print(f"Error: Could not parse cpu value '{value_str}' as integer.")
+            return None
+    return None
+
 def set_mode(mode: str) -> bool:
     """Sets the simulation mode.
 
     Args:
-        mode: The desired mode string (e.g., "normal", "noisy", "ramp").
+        mode: The desired mode string (e.g., "normal", "noisy", "ramp", "profile").
 
     Returns:
         True on success, False on failure.
     """
     print(f"Setting mode to '{mode}'...")
     # Basic validation, driver handles definitive validation
-    valid_modes = ["normal", "noisy", "ramp"]
+    valid_modes = ["normal", "noisy", "ramp", "profile"]
     if mode not in valid_modes:
         print(f"Warning: Mode '{mode}' may not be valid. Allowed: {valid_modes}")
     return set_config_value(MODE_PATH, mode)
 
+def load_profile(points: typing.Sequence[typing.Tuple[int, int]]) -> bool:
+    """Uploads a profile table for the "profile" mode.
+
+    Args:
+        points: (dt_us, temp_mc) pairs. dt_us is the time from the previous
+            point; for the first point, the time from the last point back to
+            the first one when the table loops.
+
+    Returns:
+        True on success, False on failure.
+    """
+    table = struct.pack(PROFILE_HDR_FORMAT, SIMTEMP_PROFILE_MAGIC, len(points))
+    table += b"".join(struct.pack(PROFILE_POINT_FORMAT, dt, temp) for dt, temp in points)
+    print(f"Loading profile table ({len(points)} points)...")
+    try:
+        fd = os.open(PROFILE_PATH, os.O_WRONLY)
+        try:
+            # sysfs accepts at most one page per write(); the driver reassembles the chunks
+            offset = 0
+            while offset < len(table):
+                offset += os.write(fd, table[offset:])
+        finally:
+            os.close(fd)
+        return True
+    except OSError as e:
+        print(f"Error writing to {PROFILE_PATH}: {e}")
+        return False
+
 def get_mode() -> typing.Optional[str]:
     """Gets the current simulation mode.
 
@@ -122,11 +318,36 @@ def get_mode() -> typing.Optional[str]:
     """
     return get_config_value(MODE_PATH)
 
+def set_config(**params: typing.Union[int, str]) -> bool:
+    """Applies several parameters as one atomic configuration change.
+
+    Args:
+        params: Any of sampling_ms, sampling_us, threshold_mc, mode, speed,
+            hysteresis_mc, rate_mc_per_s, agg_window_ms.
+
+    Returns:
+        True on success, False on failure (nothing is applied).
+    """
+    value = " ".join(f"{key}={val}" for key, val in params.items())
+    print(f"Setting config '{value}'...")
+    return set_config_value(CONFIG_PATH, value)
+
+def get_config() -> typing.Dict[str, str]:
+    """Gets the whole configuration as one consistent snapshot.
+
+    Returns:
+        A dict of parameter name to value string (empty on error).
+    """
+    value_str = get_config_value(CONFIG_PATH)
+    if value_str is None:
+        return {}
+    return dict(part.split('=', 1) for part in value_str.split())
+
 def get_stats() -> typing.Optional[str]:
     """Gets the driver statistics string.
 
     Returns:
-        The raw statistics string (e.g., "updates=X alerts=Y errors=Z"),
-        or None on error.
+        The raw statistics string (e.g., "updates=X alerts=Y errors=Z dropped=W
+        reads=R read_bytes=B eagain=A timeouts=T"), or None on error.
     """
     return get_config_value(STATS_PATH)
\ No newline at end of file
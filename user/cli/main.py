@@ -24,11 +24,19 @@ def view_configuration():
     sampling = conf.get_sampling_ms()
     threshold = conf.get_threshold_mc()
     mode = conf.get_mode()
+    speed = conf.get_speed()
+    hysteresis = conf.get_hysteresis_mc()
+    rate = conf.get_rate_mc_per_s()
+    cpu = conf.get_cpu()
     stats = conf.get_stats()
 
     print(f"Sampling Period (ms): {sampling if sampling is not None else 'Error reading'}")
     print(f"Alert Threshold (mC): {threshold if threshold is not None else 'Error reading'}")
     print(f"Simulation Mode       : {mode if mode is not None else 'Error reading'}")
+    print(f"Replay Speed          : {speed if speed is not None else 'Error reading'}")
+    print(f"Hysteresis (mC)       : {hysteresis if hysteresis is not None else 'Error reading'}")
+    print(f"Rate Limit (mC/s)     : {rate if rate is not None else 'Error reading'}")
+    print(f"Sampling CPU          : {cpu if cpu is not None else 'Error reading'}")
     print(f"Statistics            : {stats if stats is not None else 'Error reading'}")
     print("---------------------------")
 
@@ -38,8 +46,9 @@ def modify_configuration():
         print("\n--- Modify Configuration ---")
         print("1. Set Sampling Period (ms)")
         print("2. Set Alert Threshold (mC)")
-        print("3. Set Mode (normal|noisy|ramp)")
-        print("4. Back to Main Menu")
+        print("3. Set Mode (normal|noisy|ramp|profile)")
+        print("4. Load Profile Table (CSV file of dt_us,temp_mc lines)")
+        print("5. Back to Main Menu")
         print("--------------------------")
         choice = input("Enter choice: ")
 
@@ -58,10 +67,19 @@ def modify_configuration():
             except ValueError:
                 print("Invalid input. Please enter an integer.")
         elif choice == '3':
-            value = input("Enter new mode (normal|noisy|ramp): ").lower()
+            value = input("Enter new mode (normal|noisy|ramp|profile): ").lower()
             if not conf.set_mode(value):
                  print("Failed to set value (check permissions or dmesg).")
         elif choice == '4':
+            path = input("Enter profile CSV path: ")
+            try:
+                with open(path, 'r') as f:
+                    points = [tuple(int(v) for v in line.split(',')) for line in f if line.strip()]
+                if not conf.load_profile(points):
+                    print("Failed to load profile (check permissions or dmesg).")
+            except (OSError, ValueError) as e:
+                print(f"Invalid profile file: {e}")
+        elif choice == '5':
             break
         else:
             print("Invalid choice.")
@@ -9,8 +9,10 @@ import typing
 import fcntl # For setting O_NONBLOCK if needed, though poll handles waiting
 
 from config_file import (
-    DRIVER_DEV_PATH, SAMPLE_FORMAT, SAMPLE_SIZE_BYTES,
-    SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI, DISPLAY_TIMEZONE
+    DRIVER_DEV_PATH, SAMPLE_FORMAT, SAMPLE_SIZE_BYTES, READ_BATCH_SAMPLES,
+    SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI, SIMTEMP_SAMPLE_FLAG_RATE_HI, DISPLAY_TIMEZONE,
+    FRAME_HDR_FORMAT, FRAME_HDR_SIZE, SIMTEMP_FRAME_MAGIC, SIMTEMP_FORMAT_DELTA_V1,
+    AGG_RECORD_FORMAT, AGG_RECORD_SIZE
 )
 
 def format_timestamp_ns(timestamp_ns: int) -> str:
@@ -54,6 +56,84 @@ def parse_sample(raw_data: bytes) -> typing.Optional[typing.Tuple[int, int, int]
         print(f"Error unpacking sample data: {e}")
         return None
 
+def parse_samples(raw_data: bytes) -> typing.List[typing.Tuple[int, int, int]]:
+    """Parses a batched read into its sample records.
+
+    Args:
+        raw_data: The bytes read from the device (a multiple of SAMPLE_SIZE_BYTES).
+
+    Returns:
+        A list of (timestamp_ns, temp_mc, flags) tuples; records that fail to
+        parse are skipped.
+    """
+    samples = []
+    for offset in range(0, len(raw_data), SAMPLE_SIZE_BYTES):
+        parsed = parse_sample(raw_data[offset:offset + SAMPLE_SIZE_BYTES])
+        if parsed:
+            samples.append(parsed)
+    return samples
+
+def parse_agg_records(raw_data: bytes) -> typing.List[typing.Tuple[int, int, int, int, int, int, int]]:
+    """Parses a read() in the SIMTEMP_FORMAT_AGG_V1 format.
+
+    Args:
+        raw_data: The bytes read from the device (a multiple of AGG_RECORD_SIZE).
+
+    Returns:
+        A list of (start_ns, window_us, count, min_mc, max_mc, mean_mc, flags) tuples.
+    """
+    usable = len(raw_data) - len(raw_data) % AGG_RECORD_SIZE
+    return [struct.unpack_from(AGG_RECORD_FORMAT, raw_data, offset)
+            for offset in range(0, usable, AGG_RECORD_SIZE)]
+
+def _get_varint(data: bytes, pos: int) -> typing.Tuple[int, int]:
+    """Decodes an unsigned LEB128 varint, returns (value, next position)."""
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+def _unzigzag(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+def parse_delta_frame(raw_data: bytes) -> typing.Optional[typing.List[typing.Tuple[int, int, int]]]:
+    """Decodes one SIMTEMP_FORMAT_DELTA_V1 frame (layout in kernel/nxp_simtemp_uapi.h).
+
+    Args:
+        raw_data: The bytes returned by one read() on a file in delta format.
+
+    Returns:
+        A list of (timestamp_ns, temp_mc, flags) tuples, or None if the frame is malformed.
+    """
+    try:
+        magic, version, hdr_size, count, payload_size, ts, temp, flags = \
+            struct.unpack_from(FRAME_HDR_FORMAT, raw_data)
+        if magic != SIMTEMP_FRAME_MAGIC or version != SIMTEMP_FORMAT_DELTA_V1 or hdr_size < FRAME_HDR_SIZE:
+            print(f"Error: Bad frame header (magic=0x{magic:x}, version={version})")
+            return None
+        if len(raw_data) != hdr_size + payload_size:
+            print(f"Error: Frame is {len(raw_data)} bytes, header announces {hdr_size + payload_size}")
+            return None
+        samples = [(ts, temp, flags)]
+        pos, dt = hdr_size, 0
+        for _ in range(count - 1):
+            ddt, pos = _get_varint(raw_data, pos)
+            dt += _unzigzag(ddt)
+            value, pos = _get_varint(raw_data, pos)
+            if value & 1:
+                flags, pos = _get_varint(raw_data, pos)
+            ts += dt
+            temp += _unzigzag(value >> 1)
+            samples.append((ts, temp, flags))
+        return samples
+    except (struct.error, IndexError) as e:
+        print(f"Error decoding delta frame: {e}")
+        return None
+
 def start_sampling() -> None:
     """Continuously monitors and prints samples using poll."""
     print(f"Starting sampling from {DRIVER_DEV_PATH}. Press Ctrl+C to stop.")
@@ -83,8 +163,8 @@ def start_sampling() -> None:
 
                     if is_readable or is_alert: # Should generally have POLLIN if POLLPRI is set
                         try:
-                            # Read the binary sample data always from offset 0
-                            raw_data = os.pread(fd, SAMPLE_SIZE_BYTES,0)
+                            # Read every queued sample (up to READ_BATCH_SAMPLES) in one call
+                            raw_data = os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
                             if not raw_data:
                                 print("EOF reached on device read.")
                                 break # Exit loop on EOF
@@ -96,13 +176,13 @@ def start_sampling() -> None:
                             formatted_ts = now.strftime('%Y-%m-%dT%H:%M:%S.') + f"{now.microsecond // 1000:03d}Z"
                             # ************************
 
-                            parsed = parse_sample(raw_data)
-                            if parsed:
+                            for parsed in parse_samples(raw_data):
                                 timestamp_ns, temp_mc, flags = parsed
                                 #formatted_ts = format_timestamp_ns(timestamp_ns) # Optional: use driver timestamp
                                 temp_c = temp_mc / 1000.0
                                 # Check the actual flag from data, fallback to poll event
-                                alert_flag_set = bool(flags & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI)
+                                alert_flag_set = bool(flags & (SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI |
+                                                               SIMTEMP_SAMPLE_FLAG_RATE_HI))
                                 alert_status = 1 if alert_flag_set else 0
 
                                 prefix = "ALERT " if is_alert or alert_flag_set else ""
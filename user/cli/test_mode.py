@@ -9,10 +9,21 @@ import threading
 import struct
 import errno
 import sys
+import glob
+import fcntl
+import ctypes
+import tempfile
 
 from config_file import (
     DRIVER_DEV_PATH, TEST_PASS_CODE, TEST_FAIL_CODE, SAMPLE_SIZE_BYTES,
-    SAMPLE_FORMAT
+    SAMPLE_FORMAT, READ_BATCH_SAMPLES, DRIVER_DEV_GLOB, DRIVER_SYSFS_CLASS_PATH,
+    READ_BATCH_ARGS_FORMAT, SIMTEMP_IOC_READ_BATCH,
+    SIMTEMP_IOC_SET_FORMAT, SIMTEMP_FORMAT_DELTA_V1, FRAME_HDR_SIZE,
+    SIMTEMP_FORMAT_AGG_V1, AGG_RECORD_SIZE,
+    SIMTEMP_IOC_SET_WATERMARK, WATERMARK_ARGS_FORMAT,
+    SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI, SIMTEMP_SAMPLE_FLAG_RATE_HI, SIMTEMP_SAMPLE_FLAG_ALERT_EDGE,
+    SIMTEMP_SAMPLE_FLAG_GAP, DRIVER_BASE_NAME, DRIVER_SYSFS_PATH, HWMON_CLASS_PATH, HWMON_NAME,
+    IIO_DEVICES_PATH, IIO_SCAN_FORMAT, IIO_SCAN_SIZE, LAZY_PARAM_PATH, SIMTEMP_IOC_ACK_ALERT
 )
 import configuration as conf # Import configuration functions
 import print_samples # Needed for parse_sample
@@ -31,7 +42,8 @@ TP1_COHERENCE_READS = 3 # Number of reads to check data format
 TP1_CONFIG_DELAY_S = 1.0 # Time to wait after changing config
 # TP2 Constants
 TP2_ALERT_THRESHOLD_MC = -50000 # A very low value to force alerts
-TP2_EXPECTED_ALERTS = 2
+TP2_EXPECTED_ALERTS = 2 # Raise, then clear
+TP2_QUIET_MS = 2500 # No POLLPRI while the alert stays active (>= 2 samples at 1 s)
 # TP3 Constants (Mirroring kernel/nxp_simtemp_config.h)
 SAMPLING_MS_MIN = 100
 SAMPLING_MS_MAX = 60000
@@ -43,15 +55,150 @@ TP4_DURATION_S = 5
 TP6_RAMP_SAMPLES = 5
 TP6_NOISY_SAMPLES = 20
 TP6_NOISY_MAX_CONSECUTIVE = 2
+# TP7 Constants
+TP7_ACCUMULATE_S = 1.0
+TP7_MIN_BATCH = 5 # ~10 samples expected at 100ms, leave margin for scheduling
+
+# TP8 Constants
+TP8_SAMPLING_US = 1000 # 1 kHz, below the sampling_ms floor
+TP8_SAMPLING_US_MIN = 100
+TP8_ACCUMULATE_S = 0.2 # ~200 samples, fits in the device FIFO
+TP8_COUNT_TOLERANCE = 0.3 # Sample count may differ by 30% (scheduling of the test itself)
+TP8_PERIOD_TOLERANCE = 0.05 # Mean period must be within 5% of sampling_us
+
+# TP9 Constants
+TP9_SAMPLING_MS_FAST = 100 # Instance 1
+TP9_SAMPLING_MS_SLOW = 1000 # Instance 0
+TP9_ACCUMULATE_S = 1.0
+TP9_MIN_RATIO = 3 # Fast instance must deliver at least 3x the samples of the slow one
+
+# TP10 Constants
+TP10_ACCUMULATE_S = 0.5
+
+# TP11 Constants
+TP11_ACCUMULATE_S = 1.0 # ~10 samples at 100 ms
+TP11_MAX_SAMPLES = 1024 # More than the device FIFO holds
+TP11_MIN_SAMPLES = 5
+
+# TP12 Constants
+TP12_ACCUMULATE_S = 1.0 # ~10 samples at 100 ms
+TP12_MIN_SAMPLES = 5
+TP12_READ_SIZE = 4096
+TP12_UNKNOWN_FORMAT = 0xff
+
+# TP13 Constants
+TP13_SAMPLING_MS = 100
+TP13_WATERMARK = 5 # POLLIN after ~500 ms
+TP13_MAX_LATENCY_US = 250000 # POLLIN after ~250 ms with a watermark that is never reached
+TP13_POLL_TIMEOUT_MS = 2000
+TP13_TOLERANCE_S = 0.15
+
+# TP14 Constants
+TP14_SAMPLING_US = 100 # 10 kHz, generated in blocks of 10 per 1 ms tick
+TP14_RATE_WINDOW_S = 1.0
+TP14_RATE_TOLERANCE = 0.1 # updates/s may differ by 10%
+TP14_ACCUMULATE_S = 0.02 # ~200 samples, fits in the device FIFO
+
+# TP15 Constants
+TP15_SAMPLING_US = 10000
+TP15_PROFILE = [(100000, 20000), (100000, 40000)] # Triangle 20 C <-> 40 C, 200 ms period
+TP15_STEP_MC = 2000 # 20000 mC per 100 ms at 10 ms per sample
+TP15_STEP_TOLERANCE_MC = 1
+TP15_ACCUMULATE_S = 0.5
+TP15_MIN_SAMPLES = 20
+
+# TP16 Constants
+TP16_SAMPLING_MS = 1000
+TP16_SPEED = 100 # One virtual second every 10 ms
+TP16_ACCUMULATE_S = 0.5 # ~50 samples
+TP16_COUNT_TOLERANCE = 0.3
+
+# TP17 Constants
+TP17_SAMPLING_MS_SLOW = 60000
+TP17_SAMPLING_MS_FAST = 100
+TP17_FIRST_SAMPLE_MAX_S = 0.3 # Old period must not delay the change
+TP17_PERIOD_TOLERANCE_S = 0.03
+
+# TP18 Constants
+TP18_CONFIG = {'sampling_ms': 200, 'threshold_mc': 30000, 'mode': 'ramp'}
+
+# TP19 Constants (profile of TP15: triangle 20 C <-> 40 C, 2000 mC per 10 ms sample)
+TP19_THRESHOLD_MC = 35000
+TP19_HYSTERESIS_MC = 10000 # Alert clears at 25 C on the way down
+TP19_RATE_LOW = 100000 # mC/s, below the 200000 mC/s slope of the profile
+TP19_RATE_HIGH = 300000 # Above the slope
+TP19_ACCUMULATE_S = 0.5
+TP19_MIN_SAMPLES = 20
+
+# TP20 Constants
+TP20_SAMPLING_MS = 10
+TP20_WINDOW_MS = 100 # ~10 samples per window
+TP20_ACCUMULATE_S = 1.2
+TP20_MIN_RECORDS = 8
+
+# TP21 Constants
+TP21_SAMPLING_MS = 100
+TP21_EAGAIN_MAX_S = 0.05 # A nowait read must not wait for the next sample
+TP21_ACCUMULATE_S = 0.35 # ~3 samples
+
+# TP22 Constants
+TP22_SAMPLING_MS = 10
+TP22_THREADS = 4 # Blocking readers sharing one file
+TP22_DURATION_S = 1.0
+TP22_MIN_SAMPLES = 80 # Of ~100 produced
+
+# TP23 Constants
+TP23_SAMPLING_MS = 10
+TP23_SUBSCRIBERS = 3 # e.g. logger, alerter, dashboard
+TP23_ACCUMULATE_S = 1.0 # ~100 samples, below the ring capacity
+TP23_MIN_SAMPLES = 50
+
+# TP24 Constants
+TP24_SAMPLING_MS = 10
+TP24_ACCUMULATE_S = 0.5 # ~50 samples
+TP24_SPLICE_BYTES = 65536
+TP24_MIN_SAMPLES = 30
+TP24_DRAIN_TRIES = 10
+
+# TP25 Constants
+TP25_SAMPLING_MS = 10
+TP25_ACCUMULATE_S = 0.5 # ~50 samples per placement
+TP25_MIN_SAMPLES = 25
+TP25_INVALID_CPUS = (-2, 1 << 20) # Below -1, beyond any nr_cpu_ids
+
+# TP26 Constants
+TP26_SAMPLING_MS = 10
+TP26_ACCUMULATE_S = 0.5 # ~50 scans
+TP26_MIN_SCANS = 25
+TP26_BUFFER_LENGTH = 256 # IIO kfifo length in scans
+TP26_THRESHOLD_STEP_MC = 1000
+TP26_TEMP_MIN_MC = -50000 # Clamp range of the generator
+TP26_TEMP_MAX_MC = 150000
+
+# TP27 Constants (lazy sampling)
+TP27_SAMPLING_MS = 10
+TP27_IDLE_S = 0.3 # ~30 periods without a consumer
+TP27_ACCUMULATE_S = 0.5
+TP27_MIN_SAMPLES = 25
+
+# TP28 Constants (POLLPRI consumption)
+TP28_SAMPLING_MS = 10
+TP28_EDGE_TIMEOUT_MS = 2000
+
+# TP29 Constants (fast replay across a lazy stop)
+TP29_SAMPLING_MS = 100
+TP29_SPEED = 10 # Emission every 10 ms, the virtual clock runs 10x ahead
+TP29_ACCUMULATE_S = 0.2 # ~1.8 s virtual lead
+TP29_IDLE_S = 3.0 # Longer than the lead: real time overtakes the virtual clock
+TP29_MIN_SAMPLES = 10
 
 # --- Helper Functions ---
 
 def _read_sample(fd: int) -> typing.Optional[typing.Tuple[int, int, int]]:
     """Reads and parses a single sample using blocking os.read()."""
     try:
-        # Using simple blocking read here for simplicity
-        #raw_data = os.read(fd, SAMPLE_SIZE_BYTES)
-        raw_data = os.pread(fd, SAMPLE_SIZE_BYTES, 0) # Use pread if offset must be 0
+        # Using simple blocking read here for simplicity (one record per call)
+        raw_data = os.read(fd, SAMPLE_SIZE_BYTES)
         if not raw_data:
             print("ERROR: Read EOF unexpectedly.")
             return None
@@ -225,7 +372,7 @@ def _test_periodic_read() -> bool:
         return passed
 
 def _test_threshold_event() -> bool:
-    """TP2: Verify POLLPRI alert generation."""
+    """TP2: Verify POLLPRI is raised once per alert transition (edge-triggered)."""
     print("--- Running TP2: Threshold Event Verification ---")
     original_threshold: typing.Optional[int] = None
     alert_count: int = 0
@@ -242,17 +389,18 @@ def _test_threshold_event() -> bool:
             return False
         print(f"INFO: Original threshold: {original_threshold} mC")
 
-        print(f"INFO: Setting threshold to {TP2_ALERT_THRESHOLD_MC} mC to trigger alerts...")
-        if not conf.set_threshold_mc(TP2_ALERT_THRESHOLD_MC):
-            print("ERROR: Failed to set alert threshold. Aborting test.")
-            return False # Cleanup happens in finally
-
         print(f"INFO: Monitoring {DRIVER_DEV_PATH} for {TP2_EXPECTED_ALERTS} alerts (POLLPRI)...")
         # Use NONBLOCK for poll safety, but read logic assumes POLLPRI means data is ready
+        # Opened first: a file only sees the alert transitions after its open()
         fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
         poller = select.poll()
         poller.register(fd, select.POLLPRI) # Only interested in priority events
 
+        print(f"INFO: Setting threshold to {TP2_ALERT_THRESHOLD_MC} mC to trigger alerts...")
+        if not conf.set_threshold_mc(TP2_ALERT_THRESHOLD_MC):
+            print("ERROR: Failed to set alert threshold. Aborting test.")
+            return False # Cleanup happens in finally
+
         test_failed_explicitly = False
         while alert_count < TP2_EXPECTED_ALERTS:
             elapsed_time = time.monotonic() - start_time
@@ -272,15 +420,26 @@ def _test_threshold_event() -> bool:
                     if event_mask & select.POLLPRI:
                         alert_count += 1
                         print(f"INFO: ALERT DETECTED! ({alert_count}/{TP2_EXPECTED_ALERTS})")
-                        # Perform read to potentially clear condition in driver
-                        # Read using pread with offset 0 and NONBLOCK flag
+                        # Drain the samples; the read also consumes the POLLPRI
+                        # Read with the NONBLOCK flag
                         try:
-                            _ = os.pread(fd, SAMPLE_SIZE_BYTES, 0)
+                            _ = os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
                         except BlockingIOError:
                             print("WARN: Read after POLLPRI blocked (EAGAIN), might be OK.")
                         except OSError as e_read:
                             print(f"WARN: Error reading after POLLPRI: {e_read}")
                             # Decide if this is critical failure
+                        if alert_count == 1:
+                            # Edge-triggered: staying above the threshold must not raise it again
+                            if poller.poll(TP2_QUIET_MS):
+                                print("ERROR: POLLPRI repeated while the alert stayed active.")
+                                test_failed_explicitly = True
+                                break
+                            print(f"INFO: Setting threshold to {THRESHOLD_MC_MAX} mC to clear the alert...")
+                            if not conf.set_threshold_mc(THRESHOLD_MC_MAX):
+                                print("ERROR: Failed to clear the alert threshold.")
+                                test_failed_explicitly = True
+                                break
                     elif event_mask & (select.POLLERR | select.POLLHUP | select.POLLNVAL):
                          print(f"ERROR: Device error during poll: mask={event_mask}. Aborting.")
                          test_failed_explicitly = True
@@ -452,9 +611,9 @@ def _reader_thread_func(stop_event: threading.Event, results: dict):
             for descriptor, event_mask in events:
                  if descriptor == fd:
                       if event_mask & select.POLLIN:
-                           # Attempt to read using pread (offset 0)
+                           # Attempt to read one sample
                            try:
-                                raw_data = os.pread(fd, SAMPLE_SIZE_BYTES, 0)
+                                raw_data = os.read(fd, SAMPLE_SIZE_BYTES)
                                 if raw_data:
                                     read_count += 1
                                     # Optional: parse_sample(raw_data) to check coherence
@@ -463,7 +622,7 @@ def _reader_thread_func(stop_event: threading.Event, results: dict):
                                     errors += 1
                                     stop_event.set()
                            except BlockingIOError:
-                                # EAGAIN is expected with O_NONBLOCK + pread if no new data
+                                # EAGAIN is expected with O_NONBLOCK if no new data
                                 pass
                            except OSError as e_read:
                                 print(f"READER THREAD: Read error: {e_read}")
@@ -576,16 +735,17 @@ def _test_concurrency() -> bool:
         return passed
 
 def _test_api_contract_offset() -> bool:
-    """TP5: Verify read() fails or returns EOF for non-zero offset."""
+    """TP5: Verify positional reads are rejected on the sample stream."""
     print("--- Running TP5: API Contract - Read Offset ---")
     passed = False
     fd = -1
     try:
         fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY)
-        # Attempt pread with offset 1
+        # Attempt pread with offset 1. The device is opened as a stream
+        # (stream_open), so the kernel is expected to fail it with ESPIPE.
         read_bytes = os.pread(fd, SAMPLE_SIZE_BYTES, 1)
 
-        # Driver's current implementation returns 0 (EOF) for offset > 0
+        # Returning 0 (EOF) would also be a safe outcome
         if len(read_bytes) == 0:
              print("INFO: pread() with offset > 0 returned 0 bytes (EOF) as expected.")
              passed = True
@@ -735,7 +895,1561 @@ def _test_mode_behavior() -> bool:
         return passed
 
 
-# --- Main Test Runner ---
+def _test_batched_read() -> bool:
+    """TP7: Verify one read() returns every queued sample that fits."""
+    print("--- Running TP7: Batched Read Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if not conf.set_sampling_ms(TP1_SAMPLING_MS_FAST):
+            print(f"ERROR: Failed to set sampling_ms to {TP1_SAMPLING_MS_FAST}.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        print(f"INFO: Letting samples accumulate for {TP7_ACCUMULATE_S}s...")
+        time.sleep(TP7_ACCUMULATE_S)
+
+        raw_data = os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
+        if len(raw_data) % SAMPLE_SIZE_BYTES != 0:
+            print(f"FAIL: read() returned {len(raw_data)} bytes, not a multiple of {SAMPLE_SIZE_BYTES}.")
+            return False
+
+        samples = print_samples.parse_samples(raw_data)
+        print(f"INFO: One read() returned {len(samples)} samples.")
+        if len(samples) < TP7_MIN_BATCH:
+            print(f"FAIL: Expected at least {TP7_MIN_BATCH} queued samples in one read.")
+            return False
+
+        timestamps = [ts for ts, _temp, _flags in samples]
+        if any(later <= earlier for earlier, later in zip(timestamps, timestamps[1:])):
+            print("FAIL: Batched samples are not in increasing timestamp order.")
+            return False
+
+        print("INFO: Batch is complete and ordered.")
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Batched read failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP7: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP7 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_high_rate_sampling() -> bool:
+    """TP8: Verify sub-millisecond sampling_us periods and drift-free timing."""
+    print("--- Running TP8: High-Resolution Sampling Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+
+        if conf.set_sampling_us(TP8_SAMPLING_US_MIN - 1):
+            print("FAIL: sampling_us accepted a period below 100 us.")
+            return False
+        if not conf.set_sampling_us(TP8_SAMPLING_US):
+            print(f"ERROR: Failed to set sampling_us to {TP8_SAMPLING_US}.")
+            return False
+        if conf.get_sampling_us() != TP8_SAMPLING_US:
+            print("FAIL: sampling_us read back a different value.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP8_ACCUMULATE_S)
+        raw_data = os.read(fd, SAMPLE_SIZE_BYTES * 256)
+        samples = print_samples.parse_samples(raw_data)
+
+        expected = int(TP8_ACCUMULATE_S * 1e6 / TP8_SAMPLING_US)
+        print(f"INFO: Received {len(samples)} samples in {TP8_ACCUMULATE_S}s (expected ~{expected}).")
+        if abs(len(samples) - expected) > expected * TP8_COUNT_TOLERANCE:
+            print("FAIL: Sample count outside tolerance.")
+            return False
+
+        span_ns = samples[-1][0] - samples[0][0]
+        mean_period_us = span_ns / (len(samples) - 1) / 1000
+        print(f"INFO: Mean period {mean_period_us:.1f} us.")
+        if abs(mean_period_us - TP8_SAMPLING_US) > TP8_SAMPLING_US * TP8_PERIOD_TOLERANCE:
+            print("FAIL: Mean sampling period drifts from sampling_us.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: High-rate read failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP8: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP8 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_multi_instance() -> bool:
+    """TP9: Verify instances are independent devices with their own config and stream."""
+    print("--- Running TP9: Multi-Instance Validation ---")
+    devices = sorted(glob.glob(DRIVER_DEV_GLOB))
+    print(f"INFO: Found {len(devices)} instance(s): {' '.join(devices)}")
+    if len(devices) < 2:
+        print("INFO: Load the module with instances=2 (or more) to run this test. Skipping.")
+        print("--- TP9 Result: PASS ---")
+        return True
+
+    names = [os.path.basename(dev) for dev in devices[:2]]
+    sampling_paths = [os.path.join(DRIVER_SYSFS_CLASS_PATH, name, "sampling_ms") for name in names]
+    original = [conf.get_config_value(path) for path in sampling_paths]
+    passed = False
+    fds = []
+
+    try:
+        if None in original:
+            print("ERROR: Failed to read sampling_ms of the first two instances.")
+            return False
+        if not conf.set_config_value(sampling_paths[0], str(TP9_SAMPLING_MS_SLOW)) or \
+           not conf.set_config_value(sampling_paths[1], str(TP9_SAMPLING_MS_FAST)):
+            print("ERROR: Failed to configure instances.")
+            return False
+
+        fds = [os.open(f"/dev/{name}", os.O_RDONLY | os.O_NONBLOCK) for name in names]
+        time.sleep(TP9_ACCUMULATE_S)
+        counts = []
+        for fd in fds:
+            try:
+                counts.append(len(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)) // SAMPLE_SIZE_BYTES)
+            except BlockingIOError:
+                counts.append(0)
+
+        print(f"INFO: {names[0]} ({TP9_SAMPLING_MS_SLOW}ms): {counts[0]} samples, "
+              f"{names[1]} ({TP9_SAMPLING_MS_FAST}ms): {counts[1]} samples.")
+        if counts[1] < TP9_MIN_RATIO * max(counts[0], 1):
+            print("FAIL: Instances do not sample independently.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Multi-instance test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP9: {e}")
+    finally:
+        for fd in fds: os.close(fd)
+        for path, value in zip(sampling_paths, original):
+            if value is not None: conf.set_config_value(path, value)
+        print(f"--- TP9 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_reader_stats() -> bool:
+    """TP10: Verify the reader-side counters in stats (reads, read_bytes, eagain)."""
+    print("--- Running TP10: Reader Statistics Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if not conf.set_sampling_ms(TP1_SAMPLING_MS_FAST):
+            print(f"ERROR: Failed to set sampling_ms to {TP1_SAMPLING_MS_FAST}.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        before = _parse_stats(conf.get_stats())
+
+        # A fresh file has nothing queued yet: expect EAGAIN
+        try:
+            os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
+            print("INFO: Sample arrived right after open, EAGAIN not observed.")
+            got_eagain = False
+        except BlockingIOError:
+            got_eagain = True
+
+        time.sleep(TP10_ACCUMULATE_S)
+        raw_data = os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
+        after = _parse_stats(conf.get_stats())
+
+        if -1 in before.values() or -1 in after.values() or 'reads' not in after:
+            print("FAIL: Could not parse reader counters from stats.")
+            return False
+
+        print(f"INFO: reads {before['reads']} -> {after['reads']}, "
+              f"read_bytes {before['read_bytes']} -> {after['read_bytes']}, "
+              f"eagain {before['eagain']} -> {after['eagain']}")
+        if after['reads'] - before['reads'] < 1:
+            print("FAIL: reads counter did not increase.")
+            return False
+        if after['read_bytes'] - before['read_bytes'] < len(raw_data):
+            print(f"FAIL: read_bytes grew less than the {len(raw_data)} bytes read.")
+            return False
+        if got_eagain and after['eagain'] - before['eagain'] < 1:
+            print("FAIL: eagain counter did not increase.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Reader statistics test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP10: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP10 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _ioctl_read_batch(fd: int, since_ns: int, max_samples: int, flags: int = 0) -> typing.List[typing.Tuple[int, int, int]]:
+    """Issues SIMTEMP_IOC_READ_BATCH and returns the parsed samples."""
+    buf = ctypes.create_string_buffer(max_samples * SAMPLE_SIZE_BYTES)
+    args = bytearray(struct.pack(READ_BATCH_ARGS_FORMAT, ctypes.addressof(buf), since_ns,
+                                 max_samples, 0, flags, 0))
+    fcntl.ioctl(fd, SIMTEMP_IOC_READ_BATCH, args)
+    count = struct.unpack(READ_BATCH_ARGS_FORMAT, args)[3]
+    return [struct.unpack_from(SAMPLE_FORMAT, buf, i * SAMPLE_SIZE_BYTES) for i in range(count)]
+
+
+def _test_read_batch_ioctl() -> bool:
+    """TP11: Verify SIMTEMP_IOC_READ_BATCH (catch-up of buffered samples since a timestamp)."""
+    print("--- Running TP11: Batch Read ioctl Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if not conf.set_sampling_ms(TP1_SAMPLING_MS_FAST):
+            print(f"ERROR: Failed to set sampling_ms to {TP1_SAMPLING_MS_FAST}.")
+            return False
+        time.sleep(TP11_ACCUMULATE_S)
+
+        # Samples produced before open() are still returned by the ioctl
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        samples = _ioctl_read_batch(fd, 0, TP11_MAX_SAMPLES)
+        print(f"INFO: since=0 returned {len(samples)} samples.")
+        if len(samples) < TP11_MIN_SAMPLES:
+            print(f"FAIL: Expected at least {TP11_MIN_SAMPLES} buffered samples.")
+            return False
+        timestamps = [s[0] for s in samples]
+        if any(b <= a for a, b in zip(timestamps, timestamps[1:])):
+            print("FAIL: Timestamps are not strictly increasing.")
+            return False
+
+        # Query from the middle: exactly the newer samples, starting right after it
+        middle = len(samples) // 2
+        newer = _ioctl_read_batch(fd, timestamps[middle], TP11_MAX_SAMPLES)
+        if not newer or newer[0][0] != timestamps[middle + 1] or any(s[0] <= timestamps[middle] for s in newer):
+            print(f"FAIL: since={timestamps[middle]} did not resume after that sample.")
+            return False
+
+        # max is honoured
+        if len(_ioctl_read_batch(fd, 0, 2)) != 2:
+            print("FAIL: max=2 was not honoured.")
+            return False
+
+        # read() continues after the samples returned by the ioctl
+        last_ts = newer[-1][0]
+        try:
+            raw_data = os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)
+            first = print_samples.parse_sample(raw_data[:SAMPLE_SIZE_BYTES])
+            if first is not None and first[0] <= last_ts:
+                print("FAIL: read() returned a sample already returned by the ioctl.")
+                return False
+        except BlockingIOError:
+            pass # Caught up, nothing new yet
+
+        # Unknown flags are rejected
+        try:
+            _ioctl_read_batch(fd, 0, 1, flags=1)
+            print("FAIL: ioctl accepted non-zero flags.")
+            return False
+        except OSError as e:
+            if e.errno != errno.EINVAL:
+                print(f"FAIL: Expected EINVAL for non-zero flags, got {e}.")
+                return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Batch read ioctl test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP11: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP11 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_delta_format() -> bool:
+    """TP12: Verify the delta-encoded read() format against the raw stream."""
+    print("--- Running TP12: Delta Stream Format Validation ---")
+    passed = False
+    original_sampling = None
+    fd_raw = fd_delta = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if not conf.set_sampling_ms(TP1_SAMPLING_MS_FAST):
+            print(f"ERROR: Failed to set sampling_ms to {TP1_SAMPLING_MS_FAST}.")
+            return False
+
+        fd_delta = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        try:
+            fcntl.ioctl(fd_delta, SIMTEMP_IOC_SET_FORMAT, struct.pack("<I", TP12_UNKNOWN_FORMAT))
+            print("FAIL: Unknown format was accepted.")
+            return False
+        except OSError as e:
+            if e.errno != errno.EINVAL:
+                print(f"FAIL: Expected EINVAL for an unknown format, got {e}.")
+                return False
+        fcntl.ioctl(fd_delta, SIMTEMP_IOC_SET_FORMAT, struct.pack("<I", SIMTEMP_FORMAT_DELTA_V1))
+        fd_raw = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP12_ACCUMULATE_S)
+
+        # A buffer that only holds the header still returns the base sample
+        first = print_samples.parse_delta_frame(os.read(fd_delta, FRAME_HDR_SIZE))
+        frame = os.read(fd_delta, TP12_READ_SIZE)
+        raw_data = os.read(fd_raw, TP12_READ_SIZE)
+        decoded = print_samples.parse_delta_frame(frame)
+        raw = print_samples.parse_samples(raw_data)
+        if first is None or len(first) != 1 or decoded is None:
+            print("FAIL: Could not decode the delta frames.")
+            return False
+        decoded = first + decoded
+        print(f"INFO: raw {len(raw)} samples in {len(raw_data)} bytes, "
+              f"delta {len(decoded)} samples in {FRAME_HDR_SIZE + len(frame)} bytes")
+
+        # fd_delta was opened first: it may hold one extra leading sample
+        raw_ts = {s[0] for s in raw}
+        common = [s for s in decoded if s[0] in raw_ts]
+        if len(common) < TP12_MIN_SAMPLES or common != raw[:len(common)]:
+            print("FAIL: Decoded samples differ from the raw stream.")
+            return False
+        if len(frame) >= len(raw_data):
+            print("FAIL: Delta frame is not smaller than the raw records.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Delta format test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP12: {e}")
+    finally:
+        if fd_raw >= 0: os.close(fd_raw)
+        if fd_delta >= 0: os.close(fd_delta)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP12 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _poll_in_after(fd: int) -> typing.Optional[float]:
+    """Polls fd for POLLIN, returns the seconds it took or None on timeout."""
+    poller = select.poll()
+    poller.register(fd, select.POLLIN)
+    start = time.monotonic()
+    events = poller.poll(TP13_POLL_TIMEOUT_MS)
+    poller.unregister(fd)
+    return time.monotonic() - start if events else None
+
+
+def _test_poll_watermark() -> bool:
+    """TP13: Verify the per-file POLLIN watermark and max-latency deadline."""
+    print("--- Running TP13: Poll Watermark Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if not conf.set_sampling_ms(TP13_SAMPLING_MS):
+            print(f"ERROR: Failed to set sampling_ms to {TP13_SAMPLING_MS}.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        try:
+            fcntl.ioctl(fd, SIMTEMP_IOC_SET_WATERMARK, struct.pack(WATERMARK_ARGS_FORMAT, 0, 0))
+            print("FAIL: A watermark of 0 samples was accepted.")
+            return False
+        except OSError as e:
+            if e.errno != errno.EINVAL:
+                print(f"FAIL: Expected EINVAL for a 0 watermark, got {e}.")
+                return False
+
+        # Watermark only: POLLIN once TP13_WATERMARK samples are queued
+        fcntl.ioctl(fd, SIMTEMP_IOC_SET_WATERMARK, struct.pack(WATERMARK_ARGS_FORMAT, TP13_WATERMARK, 0))
+        elapsed = _poll_in_after(fd)
+        queued = len(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES)) // SAMPLE_SIZE_BYTES if elapsed else 0
+        print(f"INFO: watermark={TP13_WATERMARK}: POLLIN after {elapsed} s with {queued} samples queued")
+        if elapsed is None or queued < TP13_WATERMARK:
+            print(f"FAIL: POLLIN fired with fewer than {TP13_WATERMARK} samples queued.")
+            return False
+
+        # Unreachable watermark plus deadline: POLLIN after max_latency with ~3 samples
+        fcntl.ioctl(fd, SIMTEMP_IOC_SET_WATERMARK,
+                    struct.pack(WATERMARK_ARGS_FORMAT, READ_BATCH_SAMPLES, TP13_MAX_LATENCY_US))
+        elapsed = _poll_in_after(fd)
+        deadline_s = TP13_MAX_LATENCY_US / 1e6 + TP13_SAMPLING_MS / 1000
+        print(f"INFO: max_latency={TP13_MAX_LATENCY_US} us: POLLIN after {elapsed} s")
+        if elapsed is None or elapsed > deadline_s + TP13_TOLERANCE_S:
+            print(f"FAIL: POLLIN did not fire within {deadline_s} s.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Poll watermark test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP13: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP13 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_bulk_generation() -> bool:
+    """TP14: Verify 10 kHz sampling with block generation keeps rate and spacing."""
+    print("--- Running TP14: Bulk Generation Validation ---")
+    passed = False
+    original_sampling = None
+    original_mode = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        original_mode = conf.get_mode()
+        if original_sampling is None or original_mode is None:
+            print("ERROR: Failed to get initial configuration.")
+            return False
+        if not conf.set_sampling_us(TP14_SAMPLING_US) or not conf.set_mode("noisy"):
+            print(f"ERROR: Failed to set sampling_us={TP14_SAMPLING_US} mode=noisy.")
+            return False
+
+        before = _parse_stats(conf.get_stats())
+        time.sleep(TP14_RATE_WINDOW_S)
+        after = _parse_stats(conf.get_stats())
+        rate = (after['updates'] - before['updates']) / TP14_RATE_WINDOW_S
+        expected = 1e6 / TP14_SAMPLING_US
+        print(f"INFO: {rate:.0f} samples/s (expected ~{expected:.0f}).")
+        if abs(rate - expected) > expected * TP14_RATE_TOLERANCE:
+            print("FAIL: Generation rate outside tolerance.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP14_ACCUMULATE_S)
+        samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * 256))
+        if len(samples) < 2:
+            print("FAIL: Too few samples queued.")
+            return False
+
+        steps = [b[0] - a[0] for a, b in zip(samples, samples[1:])]
+        if min(steps) <= 0:
+            print("FAIL: Timestamps inside a block are not strictly increasing.")
+            return False
+        mean_period_us = sum(steps) / len(steps) / 1000
+        print(f"INFO: {len(samples)} samples, mean period {mean_period_us:.1f} us.")
+        if abs(mean_period_us - TP14_SAMPLING_US) > TP14_SAMPLING_US * TP8_PERIOD_TOLERANCE:
+            print("FAIL: Mean sampling period drifts from sampling_us.")
+            return False
+        if len(set(s[1] for s in samples)) < 2:
+            print("FAIL: Noisy mode produced a constant block.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Bulk generation test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP14: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_mode is not None: conf.set_mode(original_mode)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP14 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_profile_mode() -> bool:
+    """TP15: Verify the profile mode replays an uploaded table with interpolation."""
+    print("--- Running TP15: Profile Mode Validation ---")
+    passed = False
+    original_sampling = None
+    original_mode = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        original_mode = conf.get_mode()
+        if original_sampling is None or original_mode is None:
+            print("ERROR: Failed to get initial configuration.")
+            return False
+
+        # A point outside the temperature limits must be rejected
+        if conf.load_profile([(1000, 20000), (1000, THRESHOLD_MC_MAX + 1)]):
+            print("FAIL: Profile with an out-of-range point was accepted.")
+            return False
+        if not conf.load_profile(TP15_PROFILE):
+            print("ERROR: Failed to load the profile table.")
+            return False
+        if not conf.set_sampling_us(TP15_SAMPLING_US):
+            print(f"ERROR: Failed to set sampling_us to {TP15_SAMPLING_US}.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        if not conf.set_mode("profile") or conf.get_mode() != "profile":
+            print("FAIL: Could not select mode 'profile'.")
+            return False
+        time.sleep(TP15_ACCUMULATE_S)
+        samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+        # Skip samples generated before the mode switch
+        temps = [s[1] for s in samples]
+        while temps and temps[0] != TP15_PROFILE[0][1]:
+            temps.pop(0)
+        print(f"INFO: {len(temps)} profile samples, range [{min(temps, default=0)}, {max(temps, default=0)}] mC.")
+        if len(temps) < TP15_MIN_SAMPLES:
+            print("FAIL: Too few profile samples.")
+            return False
+
+        low, high = TP15_PROFILE[0][1], TP15_PROFILE[1][1]
+        if min(temps) != low or max(temps) != high:
+            print(f"FAIL: Replay does not span the table [{low}, {high}] mC.")
+            return False
+        for a, b in zip(temps, temps[1:]):
+            if abs(abs(b - a) - TP15_STEP_MC) > TP15_STEP_TOLERANCE_MC:
+                print(f"FAIL: Interpolation step {a} -> {b} mC, expected +/-{TP15_STEP_MC}.")
+                return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Profile mode test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP15: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_mode is not None: conf.set_mode(original_mode)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP15 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_fast_replay() -> bool:
+    """TP16: Verify the speed attribute accelerates the instance clock."""
+    print("--- Running TP16: Fast Replay Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+        if conf.set_speed(0):
+            print("FAIL: speed accepted 0.")
+            return False
+        if not conf.set_sampling_ms(TP16_SAMPLING_MS):
+            print(f"ERROR: Failed to set sampling_ms to {TP16_SAMPLING_MS}.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY)
+        if not conf.set_speed(TP16_SPEED) or conf.get_speed() != TP16_SPEED:
+            print(f"FAIL: Could not set speed to {TP16_SPEED}.")
+            return False
+        if _read_sample(fd) is None: # First accelerated tick
+            return False
+        time.sleep(TP16_ACCUMULATE_S)
+        samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+
+        expected = int(TP16_ACCUMULATE_S * 1000 * TP16_SPEED / TP16_SAMPLING_MS)
+        print(f"INFO: {len(samples)} samples in {TP16_ACCUMULATE_S}s at speed {TP16_SPEED} (expected ~{expected}).")
+        if len(samples) < 2 or abs(len(samples) - expected) > expected * TP16_COUNT_TOLERANCE:
+            print("FAIL: Emission rate does not follow the speed.")
+            return False
+        steps = {b[0] - a[0] for a, b in zip(samples, samples[1:])}
+        if steps != {TP16_SAMPLING_MS * 1000000}:
+            print(f"FAIL: Synthetic timestamps not spaced by sampling_ms: {sorted(steps)[:4]} ns.")
+            return False
+
+        # Back to real time: the instance clock must not go back
+        if not conf.set_speed(1):
+            print("ERROR: Failed to restore speed 1.")
+            return False
+        last_ts = samples[-1][0]
+        for _ in range(2):
+            sample = _read_sample(fd)
+            if sample is None:
+                return False
+            if sample[0] <= last_ts:
+                print(f"FAIL: Timestamp went back after leaving fast replay ({sample[0]} <= {last_ts}).")
+                return False
+            last_ts = sample[0]
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Fast replay test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP16: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        conf.set_speed(1)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP16 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_immediate_reschedule() -> bool:
+    """TP17: Verify a sampling period change takes effect without waiting for the old period."""
+    print("--- Running TP17: Immediate Period Change Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if original_sampling is None:
+            print("ERROR: Failed to get initial sampling rate.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY)
+        if not conf.set_sampling_ms(TP17_SAMPLING_MS_SLOW):
+            print(f"ERROR: Failed to set sampling_ms to {TP17_SAMPLING_MS_SLOW}.")
+            return False
+        time.sleep(0.2)
+        os.set_blocking(fd, False)
+        try:
+            os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES) # Drop samples of the old period
+        except BlockingIOError:
+            pass
+        os.set_blocking(fd, True)
+
+        start = time.monotonic()
+        if not conf.set_sampling_ms(TP17_SAMPLING_MS_FAST):
+            print(f"ERROR: Failed to set sampling_ms to {TP17_SAMPLING_MS_FAST}.")
+            return False
+        first = _read_sample(fd)
+        elapsed = time.monotonic() - start
+        print(f"INFO: First sample {elapsed:.3f} s after {TP17_SAMPLING_MS_SLOW} -> {TP17_SAMPLING_MS_FAST} ms.")
+        if first is None or elapsed > TP17_FIRST_SAMPLE_MAX_S:
+            print("FAIL: The new period waited for the old one.")
+            return False
+
+        second = _read_sample(fd)
+        third = _read_sample(fd)
+        if second is None or third is None:
+            return False
+        for a, b in ((first, second), (second, third)):
+            period_s = (b[0] - a[0]) / 1e9
+            if abs(period_s - TP17_SAMPLING_MS_FAST / 1000) > TP17_PERIOD_TOLERANCE_S:
+                print(f"FAIL: Period after the change is {period_s:.3f} s.")
+                return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Immediate reschedule test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP17: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None: conf.set_sampling_ms(original_sampling)
+        print(f"--- TP17 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_atomic_config() -> bool:
+    """TP18: Verify the config attribute applies several parameters at once, or none."""
+    print("--- Running TP18: Atomic Configuration Validation ---")
+    passed = False
+    original = {}
+
+    try:
+        original = conf.get_config()
+        if not original:
+            print("ERROR: Failed to read config.")
+            return False
+
+        if not conf.set_config(**TP18_CONFIG):
+            print("FAIL: Valid config write rejected.")
+            return False
+        current = conf.get_config()
+        print(f"INFO: config = {current}")
+        if (current.get('sampling_us') != str(TP18_CONFIG['sampling_ms'] * 1000) or
+                current.get('threshold_mc') != str(TP18_CONFIG['threshold_mc']) or
+                current.get('mode') != TP18_CONFIG['mode']):
+            print("FAIL: config does not reflect the written values.")
+            return False
+        if conf.get_sampling_ms() != TP18_CONFIG['sampling_ms'] or conf.get_mode() != TP18_CONFIG['mode']:
+            print("FAIL: Individual attributes disagree with config.")
+            return False
+
+        # One invalid pair must leave every parameter untouched
+        if conf.set_config(sampling_ms=SAMPLING_MS_MIN, mode="bogus"):
+            print("FAIL: Config with an invalid mode accepted.")
+            return False
+        if conf.get_config() != current:
+            print("FAIL: A rejected config write changed the configuration.")
+            return False
+
+        passed = True
+
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP18: {e}")
+    finally:
+        if original:
+            conf.set_config(**original)
+        print(f"--- TP18 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_alert_hysteresis() -> bool:
+    """TP19: Verify the hysteresis band, the rate alert and the alert edge flags."""
+    print("--- Running TP19: Alert Hysteresis and Rate Validation ---")
+    passed = False
+    original = {}
+    fd = -1
+
+    try:
+        original = conf.get_config()
+        if not original:
+            print("ERROR: Failed to read config.")
+            return False
+        if not conf.load_profile(TP15_PROFILE):
+            print("ERROR: Failed to load the profile table.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        if not conf.set_config(sampling_us=TP15_SAMPLING_US, threshold_mc=TP19_THRESHOLD_MC,
+                               hysteresis_mc=TP19_HYSTERESIS_MC, rate_mc_per_s=0, mode="profile"):
+            print("FAIL: Could not apply the alert configuration.")
+            return False
+        time.sleep(TP19_ACCUMULATE_S)
+        samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+        # Start at the bottom of the triangle, where the alert is clear
+        while samples and samples[0][1] != TP15_PROFILE[0][1]:
+            samples.pop(0)
+        print(f"INFO: {len(samples)} profile samples.")
+        if len(samples) < TP19_MIN_SAMPLES:
+            print("FAIL: Too few profile samples.")
+            return False
+
+        active = False
+        held = 0 # Samples at or below the threshold kept active by the band
+        for i, (_, temp, flags) in enumerate(samples):
+            was_active = active
+            if temp > TP19_THRESHOLD_MC:
+                active = True
+            elif temp <= TP19_THRESHOLD_MC - TP19_HYSTERESIS_MC:
+                active = False
+            if bool(flags & SIMTEMP_SAMPLE_FLAG_THRESHOLD_HI) != active:
+                print(f"FAIL: Sample {i} ({temp} mC): THRESHOLD_HI should be {active}.")
+                return False
+            if i and bool(flags & SIMTEMP_SAMPLE_FLAG_ALERT_EDGE) != (active != was_active):
+                print(f"FAIL: Sample {i} ({temp} mC): ALERT_EDGE only belongs on transitions.")
+                return False
+            if flags & SIMTEMP_SAMPLE_FLAG_RATE_HI:
+                print("FAIL: RATE_HI set with the rate alert disabled.")
+                return False
+            if active and temp <= TP19_THRESHOLD_MC:
+                held += 1
+        if not held:
+            print("FAIL: The hysteresis band never held the alert.")
+            return False
+
+        # The profile changes 200000 mC/s on every sample
+        for rate, expected in ((TP19_RATE_LOW, True), (TP19_RATE_HIGH, False)):
+            if not conf.set_rate_mc_per_s(rate):
+                print(f"FAIL: Could not set rate_mc_per_s to {rate}.")
+                return False
+            os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES) # Drop samples of the old limit
+            time.sleep(TP19_ACCUMULATE_S / 2)
+            samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+            flagged = [bool(f & SIMTEMP_SAMPLE_FLAG_RATE_HI) for _, _, f in samples[1:]]
+            print(f"INFO: rate_mc_per_s={rate}: {sum(flagged)}/{len(flagged)} samples flagged RATE_HI.")
+            if not flagged or any(f != expected for f in flagged):
+                print(f"FAIL: RATE_HI should be {expected} on every sample.")
+                return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Alert test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP19: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original:
+            conf.set_config(**original)
+        print(f"--- TP19 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_windowed_aggregation() -> bool:
+    """TP20: Verify the aggregated read() format against the raw stream."""
+    print("--- Running TP20: Windowed Aggregation Validation ---")
+    passed = False
+    original = {}
+    fd_raw = fd_agg = -1
+
+    try:
+        original = conf.get_config()
+        if not original:
+            print("ERROR: Failed to read config.")
+            return False
+        if conf.set_agg_window_ms(1):
+            print("FAIL: Window below the minimum was accepted.")
+            return False
+
+        fd_agg = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        fd_raw = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        fcntl.ioctl(fd_agg, SIMTEMP_IOC_SET_FORMAT, struct.pack("<I", SIMTEMP_FORMAT_AGG_V1))
+        if not conf.set_config(sampling_ms=TP20_SAMPLING_MS, mode="ramp", agg_window_ms=TP20_WINDOW_MS):
+            print("FAIL: Could not enable the aggregation.")
+            return False
+        time.sleep(TP20_ACCUMULATE_S)
+
+        records = print_samples.parse_agg_records(os.read(fd_agg, AGG_RECORD_SIZE * READ_BATCH_SAMPLES))
+        raw = print_samples.parse_samples(os.read(fd_raw, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES * 4))
+        print(f"INFO: {len(records)} window records for {len(raw)} raw samples.")
+        if len(records) < TP20_MIN_RECORDS:
+            print("FAIL: Too few window records.")
+            return False
+
+        window_ns = TP20_WINDOW_MS * 1000000
+        checked = 0
+        for i, (start_ns, window_us, count, min_mc, max_mc, mean_mc, _) in enumerate(records):
+            if window_us != TP20_WINDOW_MS * 1000 or start_ns % window_ns:
+                print(f"FAIL: Window {start_ns}/{window_us} us is not aligned on {TP20_WINDOW_MS} ms.")
+                return False
+            if not count or not min_mc <= mean_mc <= max_mc:
+                print(f"FAIL: Inconsistent record count={count} min={min_mc} mean={mean_mc} max={max_mc}.")
+                return False
+            # Windows fully covered by the raw stream must match it exactly;
+            # the first one only holds the samples after the aggregation started
+            if not i or not raw or start_ns < raw[0][0] or start_ns + window_ns > raw[-1][0]:
+                continue
+            temps = [t for ts, t, _ in raw if start_ns <= ts < start_ns + window_ns]
+            mean = abs(sum(temps)) // len(temps) * (1 if sum(temps) >= 0 else -1)
+            if (count, min_mc, max_mc, mean_mc) != (len(temps), min(temps), max(temps), mean):
+                print(f"FAIL: Window at {start_ns} differs from the raw samples.")
+                return False
+            checked += 1
+        if checked < TP20_MIN_RECORDS // 2:
+            print(f"FAIL: Only {checked} windows could be checked against the raw stream.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Aggregation test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP20: {e}")
+    finally:
+        if fd_raw >= 0: os.close(fd_raw)
+        if fd_agg >= 0: os.close(fd_agg)
+        if original:
+            conf.set_config(**original)
+        print(f"--- TP20 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _read_nowait(fd: int, size: int) -> bytes:
+    """One read() with RWF_NOWAIT, as io_uring issues it first."""
+    buf = bytearray(size)
+    n = os.preadv(fd, [buf], -1, os.RWF_NOWAIT) # -1: stream position, no pread
+    return bytes(buf[:n])
+
+
+def _test_nowait_read() -> bool:
+    """TP21: Verify RWF_NOWAIT reads on a blocking file never sleep."""
+    print("--- Running TP21: Nowait (io_uring) Read Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+    size = SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP21_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY) # Blocking file
+        try:
+            while _read_nowait(fd, size):
+                pass # Drain
+        except BlockingIOError:
+            pass
+        except OSError as e:
+            if e.errno == errno.EOPNOTSUPP:
+                print("FAIL: The device does not support RWF_NOWAIT (FMODE_NOWAIT).")
+                return False
+            raise
+
+        start = time.monotonic()
+        try:
+            data = _read_nowait(fd, size)
+            print(f"INFO: Drained file returned {len(data)} bytes.")
+        except BlockingIOError:
+            data = b""
+        elapsed = time.monotonic() - start
+        print(f"INFO: Nowait read on an empty file returned after {elapsed * 1000:.1f} ms.")
+        if elapsed > TP21_EAGAIN_MAX_S:
+            print("FAIL: The nowait read slept.")
+            return False
+
+        # io_uring completes the read when poll reports the file readable
+        poller = select.poll()
+        poller.register(fd, select.POLLIN)
+        if not poller.poll(TP21_SAMPLING_MS * 3):
+            print("FAIL: No POLLIN within three periods.")
+            return False
+        time.sleep(TP21_ACCUMULATE_S)
+        samples = print_samples.parse_samples(_read_nowait(fd, size))
+        print(f"INFO: Nowait read after POLLIN returned {len(samples)} samples.")
+        if len(samples) < 2:
+            print("FAIL: The nowait read did not return the queued samples.")
+            return False
+        if any(b[0] <= a[0] for a, b in zip(samples, samples[1:])):
+            print("FAIL: Timestamps are not increasing.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Nowait read test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP21: {e}")
+    finally:
+        if fd >= 0: os.close(fd)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP21 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _shared_reader_func(fd: int, stop_event: threading.Event, results: list):
+    """Thread function for TP22: one-sample blocking reads on a shared file."""
+    stamps, errors = [], []
+    try:
+        while not stop_event.is_set():
+            sample = print_samples.parse_sample(os.read(fd, SAMPLE_SIZE_BYTES))
+            if sample:
+                stamps.append(sample[0])
+    except OSError as e:
+        errors.append(e) # EAGAIN included: a blocking read must not return it
+    results.append((stamps, errors))
+
+
+def _test_shared_blocking_read() -> bool:
+    """TP22: Verify blocking readers sharing one file never get EAGAIN or duplicates."""
+    print("--- Running TP22: Shared Blocking Read Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+    stop_event = threading.Event()
+    threads = []
+    results = []
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP22_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY) # Blocking, shared by every thread
+        for _ in range(TP22_THREADS):
+            threads.append(threading.Thread(target=_shared_reader_func, args=(fd, stop_event, results)))
+        for t in threads:
+            t.start()
+        time.sleep(TP22_DURATION_S)
+        stop_event.set()
+        for t in threads:
+            t.join(timeout=2.0)
+
+        if len(results) != TP22_THREADS:
+            print("FAIL: A reader thread did not finish.")
+            return False
+        stamps = [ts for thread_stamps, _ in results for ts in thread_stamps]
+        errors = [e for _, thread_errors in results for e in thread_errors]
+        print(f"INFO: {len(stamps)} samples over {TP22_THREADS} threads, errors: {errors}")
+        if errors:
+            print("FAIL: A blocking read returned an error.")
+            return False
+        if len(set(stamps)) != len(stamps):
+            print("FAIL: A sample was returned to two readers of the same file.")
+            return False
+        if len(stamps) < TP22_MIN_SAMPLES:
+            print("FAIL: Too few samples were read.")
+            return False
+
+        passed = True
+
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP22: {e}")
+    finally:
+        stop_event.set()
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        for t in threads:
+            t.join(timeout=2.0)
+        if fd >= 0: os.close(fd)
+        print(f"--- TP22 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_fanout() -> bool:
+    """TP23: Verify every open file receives the full sample stream."""
+    print("--- Running TP23: Broadcast Fan-out Validation ---")
+    passed = False
+    original_sampling = None
+    fds = []
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP23_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        fds = [os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK) for _ in range(TP23_SUBSCRIBERS)]
+        time.sleep(TP23_ACCUMULATE_S)
+
+        streams = []
+        for fd in fds:
+            stamps = []
+            try:
+                while True:
+                    stamps += [ts for ts, _, _ in print_samples.parse_samples(
+                        os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))]
+            except BlockingIOError:
+                pass
+            streams.append(stamps)
+        print(f"INFO: Samples per subscriber: {[len(st) for st in streams]}")
+
+        # Files opened at different times may differ in the first sample only
+        common_start = max(st[0] for st in streams if st) if all(streams) else None
+        if common_start is None:
+            print("FAIL: A subscriber received nothing.")
+            return False
+        trimmed = [[ts for ts in st if ts >= common_start] for st in streams]
+        common_end = min(st[-1] for st in trimmed)
+        trimmed = [[ts for ts in st if ts <= common_end] for st in trimmed]
+        if any(st != trimmed[0] for st in trimmed):
+            print("FAIL: Subscribers received different samples.")
+            return False
+        if len(trimmed[0]) < TP23_MIN_SAMPLES:
+            print("FAIL: Too few samples in the common stream.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Fan-out test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP23: {e}")
+    finally:
+        for fd in fds:
+            os.close(fd)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP23 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_splice_capture() -> bool:
+    """TP24: Verify splice() moves samples from the device to a file through a pipe."""
+    print("--- Running TP24: splice() Capture Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+    pipe_r = pipe_w = -1
+    capture = None
+
+    if not hasattr(os, "splice"):
+        print("INFO: os.splice() needs Python 3.10 or newer, skipping.")
+        print("--- TP24 Result: PASS ---")
+        return True
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP24_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        pipe_r, pipe_w = os.pipe()
+        capture = tempfile.TemporaryFile()
+        time.sleep(TP24_ACCUMULATE_S)
+
+        moved = os.splice(fd, pipe_w, TP24_SPLICE_BYTES)
+        print(f"INFO: splice() moved {moved} bytes from the device into the pipe.")
+        if moved <= 0 or moved % SAMPLE_SIZE_BYTES:
+            print("FAIL: splice() did not move whole samples.")
+            return False
+        written = 0
+        while written < moved:
+            written += os.splice(pipe_r, capture.fileno(), moved - written)
+
+        capture.seek(0)
+        samples = print_samples.parse_samples(capture.read())
+        print(f"INFO: Captured {len(samples)} samples.")
+        if len(samples) < TP24_MIN_SAMPLES:
+            print("FAIL: Too few samples captured.")
+            return False
+        if any(b[0] <= a[0] for a, b in zip(samples, samples[1:])):
+            print("FAIL: Captured timestamps are not increasing.")
+            return False
+
+        # Nothing pending: splice() on a non-blocking file fails like read()
+        try:
+            for _ in range(TP24_DRAIN_TRIES): # A new sample may land between two calls
+                os.splice(fd, pipe_w, SAMPLE_SIZE_BYTES)
+                os.read(pipe_r, SAMPLE_SIZE_BYTES)
+            print("FAIL: splice() on a drained non-blocking file did not return EAGAIN.")
+            return False
+        except BlockingIOError:
+            pass
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: splice() capture failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP24: {e}")
+    finally:
+        if capture: capture.close()
+        for pfd in (pipe_r, pipe_w, fd):
+            if pfd >= 0: os.close(pfd)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP24 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_cpu_affinity() -> bool:
+    """TP25: Verify the cpu attribute pins sampling without interrupting the stream."""
+    print("--- Running TP25: Sampling CPU Placement Validation ---")
+    passed = False
+    original_sampling = None
+    original_cpu = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        original_cpu = conf.get_cpu()
+        if original_cpu is None:
+            print("ERROR: Failed to read the cpu attribute.")
+            return False
+        if not conf.set_sampling_ms(TP25_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        cpus = sorted(os.sched_getaffinity(0))
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        for cpu in (cpus[0], cpus[-1], -1):
+            if not conf.set_cpu(cpu) or conf.get_cpu() != cpu:
+                print(f"FAIL: cpu did not read back as {cpu}.")
+                return False
+            # Drop what was sampled before the move, then check the timer keeps ticking
+            try:
+                while os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES):
+                    pass
+            except BlockingIOError:
+                pass
+            time.sleep(TP25_ACCUMULATE_S)
+            try:
+                samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+            except BlockingIOError:
+                samples = []
+            print(f"INFO: cpu={cpu}: {len(samples)} samples in {TP25_ACCUMULATE_S} s.")
+            if len(samples) < TP25_MIN_SAMPLES:
+                print("FAIL: Sampling stalled after the CPU change.")
+                return False
+            if any(b[0] <= a[0] for a, b in zip(samples, samples[1:])):
+                print("FAIL: Timestamps are not increasing after the CPU change.")
+                return False
+
+        for cpu in TP25_INVALID_CPUS:
+            if conf.set_cpu(cpu):
+                print(f"FAIL: Invalid cpu {cpu} was accepted.")
+                return False
+        if conf.get_cpu() != -1:
+            print("FAIL: A rejected write changed the cpu attribute.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: CPU placement test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP25: {e}")
+    finally:
+        if fd >= 0:
+            os.close(fd)
+        if original_cpu is not None:
+            conf.set_cpu(original_cpu)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP25 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _find_framework_dir(pattern: str, name: str) -> typing.Optional[str]:
+    """Returns the hwmon/IIO sysfs directory named name whose parent is simtemp0's device."""
+    parent = os.path.realpath(os.path.join(DRIVER_SYSFS_PATH, "device"))
+    for path in sorted(glob.glob(pattern)):
+        if conf.get_config_value(os.path.join(path, "name")) != name:
+            continue
+        # hwmon (a class) links to its parent, IIO devices (a bus) sit below it
+        if os.path.realpath(os.path.join(path, "device")) == parent or \
+           os.path.realpath(path).startswith(parent + os.sep):
+            return path
+    return None
+
+
+def _test_framework_views() -> bool:
+    """TP26: Verify the hwmon and IIO devices report the same producer as /dev/simtemp0."""
+    print("--- Running TP26: hwmon / IIO Interface Validation ---")
+    passed = False
+    original_sampling = None
+    original_threshold = None
+    iio_dir = None
+    fd = -1
+
+    try:
+        hwmon_dir = _find_framework_dir(os.path.join(HWMON_CLASS_PATH, "hwmon*"), HWMON_NAME)
+        iio_dir = _find_framework_dir(os.path.join(IIO_DEVICES_PATH, "iio:device*"), DRIVER_BASE_NAME)
+        print(f"INFO: hwmon: {hwmon_dir}, IIO: {iio_dir}")
+        if not hwmon_dir and not iio_dir:
+            print("INFO: Kernel without hwmon and IIO support, skipping.")
+            passed = True
+            return passed
+
+        original_threshold = conf.get_threshold_mc()
+        if hwmon_dir:
+            temp = int(conf.get_config_value(os.path.join(hwmon_dir, "temp1_input")))
+            alarm = int(conf.get_config_value(os.path.join(hwmon_dir, "temp1_max_alarm")))
+            hw_max = int(conf.get_config_value(os.path.join(hwmon_dir, "temp1_max")))
+            print(f"INFO: hwmon temp1_input={temp} temp1_max={hw_max} temp1_max_alarm={alarm}")
+            if not TP26_TEMP_MIN_MC <= temp <= TP26_TEMP_MAX_MC or alarm not in (0, 1):
+                print("FAIL: hwmon reports an impossible reading.")
+                return False
+            if hw_max != original_threshold:
+                print("FAIL: temp1_max differs from threshold_mc.")
+                return False
+            new_max = original_threshold + TP26_THRESHOLD_STEP_MC
+            if not conf.set_config_value(os.path.join(hwmon_dir, "temp1_max"), str(new_max)) or \
+               conf.get_threshold_mc() != new_max:
+                print("FAIL: Writing temp1_max did not set threshold_mc.")
+                return False
+
+        if iio_dir:
+            if conf.get_config_value(os.path.join(iio_dir, "in_temp_scale")) != "1":
+                print("FAIL: in_temp_scale is not 1 (milli-Celsius).")
+                return False
+            original_sampling = conf.get_sampling_ms()
+            if not conf.set_sampling_ms(TP26_SAMPLING_MS):
+                print("ERROR: Failed to set sampling period.")
+                return False
+            for attr, value in (("scan_elements/in_temp_en", "1"), ("scan_elements/in_timestamp_en", "1"),
+                                ("buffer/length", str(TP26_BUFFER_LENGTH)), ("buffer/enable", "1")):
+                if not conf.set_config_value(os.path.join(iio_dir, attr), value):
+                    print(f"FAIL: Could not write {attr}.")
+                    return False
+
+            fd = os.open(os.path.join("/dev", os.path.basename(iio_dir)), os.O_RDONLY | os.O_NONBLOCK)
+            time.sleep(TP26_ACCUMULATE_S)
+            raw = os.read(fd, IIO_SCAN_SIZE * TP26_BUFFER_LENGTH)
+            scans = [struct.unpack_from(IIO_SCAN_FORMAT, raw, off)
+                     for off in range(0, len(raw) - IIO_SCAN_SIZE + 1, IIO_SCAN_SIZE)]
+            print(f"INFO: IIO buffer returned {len(scans)} scans.")
+            if len(scans) < TP26_MIN_SCANS:
+                print("FAIL: Too few scans in the IIO buffer.")
+                return False
+            if any(not TP26_TEMP_MIN_MC <= t <= TP26_TEMP_MAX_MC for t, _ in scans):
+                print("FAIL: IIO scan with an impossible temperature.")
+                return False
+            if any(b[1] <= a[1] for a, b in zip(scans, scans[1:])):
+                print("FAIL: IIO timestamps are not increasing.")
+                return False
+
+        passed = True
+
+    except (OSError, TypeError, ValueError) as e:
+        print(f"FAIL: hwmon/IIO test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP26: {e}")
+    finally:
+        if fd >= 0:
+            os.close(fd)
+        if iio_dir:
+            conf.set_config_value(os.path.join(iio_dir, "buffer/enable"), "0")
+        if original_threshold is not None:
+            conf.set_threshold_mc(original_threshold)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP26 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_lazy_sampling() -> bool:
+    """TP27: Verify that with lazy=1 an instance only samples while it is open."""
+    print("--- Running TP27: Lazy Sampling Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    def updates() -> int:
+        return _parse_stats(conf.get_stats())['updates']
+
+    try:
+        if conf.get_config_value(LAZY_PARAM_PATH) != "Y":
+            print("INFO: Module loaded without lazy=1, skipping.")
+            passed = True
+            return passed
+
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP27_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        # No other consumer of simtemp0 may be open during this test
+        before = updates()
+        time.sleep(TP27_IDLE_S)
+        if updates() != before:
+            print("FAIL: Samples were generated while the device was closed.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP27_ACCUMULATE_S)
+        try:
+            samples = print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+        except BlockingIOError:
+            samples = []
+        print(f"INFO: {len(samples)} samples in {TP27_ACCUMULATE_S} s after open.")
+        if len(samples) < TP27_MIN_SAMPLES:
+            print("FAIL: Opening the device did not start sampling.")
+            return False
+        if not samples[0][2] & SIMTEMP_SAMPLE_FLAG_GAP or \
+           any(flags & SIMTEMP_SAMPLE_FLAG_GAP for _, _, flags in samples[1:]):
+            print("FAIL: Only the first sample after the resume must carry the GAP flag.")
+            return False
+
+        os.close(fd)
+        fd = -1
+        before = updates()
+        time.sleep(TP27_IDLE_S)
+        if updates() != before:
+            print("FAIL: Sampling continued after the last close.")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Lazy sampling test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP27: {e}")
+    finally:
+        if fd >= 0:
+            os.close(fd)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP27 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+def _test_alert_pending() -> bool:
+    """TP28: Verify POLLPRI stays pending across polls until the file consumes it."""
+    print("--- Running TP28: POLLPRI Consumption Validation ---")
+    passed = False
+    original_sampling = None
+    original_threshold = None
+    epoll = None
+    fd = -1
+
+    try:
+        original_sampling = conf.get_sampling_ms()
+        original_threshold = conf.get_threshold_mc()
+        if not conf.set_sampling_ms(TP28_SAMPLING_MS):
+            print("ERROR: Failed to set sampling period.")
+            return False
+
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        poller = select.poll()
+        poller.register(fd, select.POLLPRI)
+        if not conf.set_threshold_mc(TP2_ALERT_THRESHOLD_MC):
+            print("ERROR: Failed to set alert threshold.")
+            return False
+        if not poller.poll(TP28_EDGE_TIMEOUT_MS):
+            print("FAIL: No POLLPRI after raising the alert.")
+            return False
+
+        # Neither another poll(), a select() nor adding an epoll item may consume it
+        if not poller.poll(0):
+            print("FAIL: A second poll() lost the pending POLLPRI.")
+            return False
+        if fd not in select.select([], [], [fd], 0)[2]:
+            print("FAIL: select() did not report the pending POLLPRI.")
+            return False
+        epoll = select.epoll()
+        epoll.register(fd, select.EPOLLPRI)
+        if not epoll.poll(0):
+            print("FAIL: EPOLL_CTL_ADD swallowed the pending POLLPRI.")
+            return False
+
+        # The alert stays active: once acknowledged no new edge is reported
+        fcntl.ioctl(fd, SIMTEMP_IOC_ACK_ALERT)
+        if poller.poll(0) or epoll.poll(0):
+            print("FAIL: POLLPRI still pending after SIMTEMP_IOC_ACK_ALERT.")
+            return False
+
+        # Clearing the alert is a new edge, consumed by a read() that returns data
+        if not conf.set_threshold_mc(THRESHOLD_MC_MAX) or not poller.poll(TP28_EDGE_TIMEOUT_MS):
+            print("FAIL: No POLLPRI after clearing the alert.")
+            return False
+        while True:
+            try:
+                if not os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES):
+                    break
+            except BlockingIOError:
+                break
+        if poller.poll(0):
+            print("FAIL: POLLPRI still pending after read().")
+            return False
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: POLLPRI consumption test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP28: {e}")
+    finally:
+        if epoll:
+            epoll.close()
+        if fd >= 0:
+            os.close(fd)
+        if original_threshold is not None:
+            conf.set_threshold_mc(original_threshold)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP28 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
+
+# --- Main Test Runner ---
+
+def _test_replay_resume() -> bool:
+    """TP29: Verify the instance clock stays sane when fast replay resumes after a lazy stop."""
+    print("--- Running TP29: Fast Replay Resume Validation ---")
+    passed = False
+    original_sampling = None
+    fd = -1
+
+    def drain(fd: int) -> typing.List[typing.Tuple[int, int, int]]:
+        try:
+            return print_samples.parse_samples(os.read(fd, SAMPLE_SIZE_BYTES * READ_BATCH_SAMPLES))
+        except BlockingIOError:
+            return []
+
+    try:
+        if conf.get_config_value(LAZY_PARAM_PATH) != "Y":
+            print("INFO: Module loaded without lazy=1, skipping.")
+            passed = True
+            return passed
+
+        original_sampling = conf.get_sampling_ms()
+        if not conf.set_sampling_ms(TP29_SAMPLING_MS) or not conf.set_speed(TP29_SPEED):
+            print("ERROR: Failed to set sampling period and speed.")
+            return False
+
+        # Run ahead of real time, then stop until real time has overtaken the virtual clock
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP29_ACCUMULATE_S)
+        before = drain(fd)
+        os.close(fd)
+        fd = -1
+        time.sleep(TP29_IDLE_S)
+
+        resume_ns = time.monotonic_ns()
+        fd = os.open(DRIVER_DEV_PATH, os.O_RDONLY | os.O_NONBLOCK)
+        time.sleep(TP29_ACCUMULATE_S)
+        samples = drain(fd)
+        print(f"INFO: {len(before)} samples before the stop, {len(samples)} after the resume.")
+        if len(samples) < TP29_MIN_SAMPLES:
+            print("FAIL: Too few samples after the resume.")
+            return False
+        if not samples[0][2] & SIMTEMP_SAMPLE_FLAG_GAP or samples[0][0] < resume_ns:
+            print(f"FAIL: The GAP sample is not stamped at the resume ({samples[0][0]} < {resume_ns}).")
+            return False
+        if before and samples[0][0] <= before[-1][0]:
+            print(f"FAIL: Timestamp went back across the stop ({samples[0][0]} <= {before[-1][0]}).")
+            return False
+        steps = {b[0] - a[0] for a, b in zip(samples, samples[1:])}
+        if steps != {TP29_SAMPLING_MS * 1000000}:
+            print(f"FAIL: Replayed timestamps not spaced by sampling_ms: {sorted(steps)[:4]} ns.")
+            return False
+
+        # Back to real time: the instance clock must not have fallen behind CLOCK_MONOTONIC
+        if not conf.set_speed(1):
+            print("ERROR: Failed to restore speed 1.")
+            return False
+        os.set_blocking(fd, True)
+        drain(fd)
+        last_ts = None
+        for _ in range(2):
+            sample = _read_sample(fd)
+            if sample is None:
+                return False
+            if sample[0] < resume_ns:
+                print(f"FAIL: Instance clock behind CLOCK_MONOTONIC ({sample[0]} < {resume_ns}).")
+                return False
+            if last_ts is not None and sample[0] - last_ts < TP29_SAMPLING_MS * 1000000 // 2:
+                print(f"FAIL: Real-time samples only {sample[0] - last_ts} ns apart.")
+                return False
+            last_ts = sample[0]
+
+        passed = True
+
+    except OSError as e:
+        print(f"FAIL: Fast replay resume test failed: {e}")
+    except Exception as e:
+        print(f"ERROR: Unexpected exception in TP29: {e}")
+    finally:
+        if fd >= 0:
+            os.close(fd)
+        conf.set_speed(1)
+        if original_sampling is not None:
+            conf.set_sampling_ms(original_sampling)
+        print(f"--- TP29 Result: {'PASS' if passed else 'FAIL'} ---")
+        return passed
+
 
 def run_all_tests() -> int:
     """Runs all TP tests sequentially."""
@@ -763,6 +2477,29 @@ def run_all_tests() -> int:
         _test_concurrency,
         _test_api_contract_offset,
         _test_mode_behavior,
+        _test_batched_read,
+        _test_high_rate_sampling,
+        _test_multi_instance,
+        _test_reader_stats,
+        _test_read_batch_ioctl,
+        _test_delta_format,
+        _test_poll_watermark,
+        _test_bulk_generation,
+        _test_profile_mode,
+        _test_fast_replay,
+        _test_immediate_reschedule,
+        _test_atomic_config,
+        _test_alert_hysteresis,
+        _test_windowed_aggregation,
+        _test_nowait_read,
+        _test_shared_blocking_read,
+        _test_fanout,
+        _test_splice_capture,
+        _test_cpu_affinity,
+        _test_framework_views,
+        _test_lazy_sampling,
+        _test_alert_pending,
+        _test_replay_resume,
     ]
 
     results = {}
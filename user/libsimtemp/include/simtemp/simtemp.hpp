@@ -0,0 +1,212 @@
+/**
+ * @file    simtemp.hpp
+ * @author  Omar Mendiola
+ * @brief   libsimtemp: native C++ client of the NXP simtemp driver.
+ * Device is an RAII handle on /dev/simtemp<N> with batched read() and the
+ * ioctls of nxp_simtemp_uapi.h. Ring maps the device sample ring and hands
+ * out the pending records in place. Multiplexer waits on many devices with
+ * one epoll instance. Errors are reported as std::system_error; "nothing
+ * to read" is an empty result, not an error.
+ * @version 0.1
+ * @date    2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef SIMTEMP_SIMTEMP_HPP_
+#define SIMTEMP_SIMTEMP_HPP_
+
+#include <sys/epoll.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nxp_simtemp_uapi.h"
+
+namespace simtemp {
+
+using Sample = struct simtemp_sample;
+
+/**
+ * @brief Contiguous run of samples, either in a caller buffer or in the ring.
+ */
+struct SampleSpan {
+    const Sample *data = nullptr;
+    std::size_t size = 0;
+
+    const Sample *begin() const noexcept { return data; }
+    const Sample *end() const noexcept { return data + size; }
+    bool empty() const noexcept { return size == 0; }
+    const Sample &operator[](std::size_t i) const noexcept { return data[i]; }
+};
+
+/**
+ * @brief Open file on a simtemp device node.
+ * Move-only; the descriptor is closed by the destructor.
+ */
+class Device {
+public:
+    /**
+     * @brief Opens a device node.
+     * @param path Device node, e.g. Device::path_of(0).
+     * @param nonblock Open with O_NONBLOCK (read() returns an empty span
+     *                 instead of blocking).
+     */
+    explicit Device(const std::string &path, bool nonblock = true);
+    ~Device();
+
+    Device(Device &&other) noexcept;
+    Device &operator=(Device &&other) noexcept;
+    Device(const Device &) = delete;
+    Device &operator=(const Device &) = delete;
+
+    /** @brief Node of an instance: /dev/simtemp<instance>. */
+    static std::string path_of(unsigned int instance);
+    /** @brief Every simtemp node present, sorted by instance number. */
+    static std::vector<std::string> enumerate();
+
+    int fd() const noexcept { return fd_; }
+    const std::string &path() const noexcept { return path_; }
+    /** @brief sysfs directory of the instance, /sys/class/misc/simtemp<N>. */
+    std::string sysfs_dir() const;
+
+    /**
+     * @brief Reads every pending sample that fits, in one read() call.
+     * @param buf Destination, at least @max samples.
+     * @param max Capacity of @buf.
+     * @return The samples read; empty if none was pending (non-blocking).
+     */
+    SampleSpan read(Sample *buf, std::size_t max);
+
+    /**
+     * @brief SIMTEMP_IOC_READ_BATCH: samples newer than a timestamp.
+     * @param since_ns Only samples with a greater timestamp_ns (0 = all buffered).
+     * @param buf Destination, at least @max samples.
+     * @param max Capacity of @buf.
+     * @return The samples copied, oldest first.
+     */
+    SampleSpan read_since(std::uint64_t since_ns, Sample *buf, std::size_t max);
+
+    /** @brief SIMTEMP_IOC_SET_WATERMARK. */
+    void set_watermark(std::uint32_t samples, std::uint32_t max_latency_us = 0);
+    /** @brief SIMTEMP_IOC_SET_FORMAT (SIMTEMP_FORMAT_*). */
+    void set_format(std::uint32_t format);
+    /** @brief SIMTEMP_IOC_ACK_ALERT: consumes POLLPRI (Ring clients, which never read()). */
+    void ack_alert();
+
+    /**
+     * @brief Reads one counter of the sysfs stats attribute.
+     * @param name Counter name, e.g. "dropped".
+     * @return The counter value.
+     */
+    std::uint64_t stat(const std::string &name) const;
+
+private:
+    int fd_ = -1;
+    std::string path_;
+};
+
+/**
+ * @brief Zero-copy reader of the mmap()ed sample ring of one file.
+ *
+ * Maps SIMTEMP_MMAP_OFF_RING read-only and the file's cursor page
+ * read-write. peek() returns pending records in place; the producer may
+ * overwrite them while they are used, so after processing a span the caller
+ * must release() it, which tells how many leading records of the span were
+ * overwritten and must be discarded. The cursor is shared with read() on
+ * the same Device, and poll()/epoll on it reports POLLIN against this
+ * cursor. Move-only; unmaps in the destructor. Not thread-safe.
+ */
+class Ring {
+public:
+    explicit Ring(const Device &dev);
+    ~Ring();
+
+    Ring(Ring &&other) noexcept;
+    Ring &operator=(Ring &&other) noexcept;
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    /**
+     * @brief Pending records, in place, up to the end of the ring storage.
+     * A reader that was lapped skips to the oldest stored record first and
+     * the gap is added to dropped(). Call again after release() to get the
+     * records after a wrap.
+     * @param max Maximum number of records.
+     * @return The records; empty if the reader is up to date.
+     */
+    SampleSpan peek(std::size_t max = SIZE_MAX);
+
+    /**
+     * @brief Consumes a span returned by the last peek().
+     * @param span The span.
+     * @return Number of leading records of @span the producer overwrote
+     *         meanwhile (their contents are invalid); also added to dropped().
+     */
+    std::size_t release(const SampleSpan &span);
+
+    /** @brief Records pending for this reader. */
+    std::uint64_t pending() const noexcept;
+    /** @brief Records lost to the producer lapping this reader. */
+    std::uint64_t dropped() const noexcept { return dropped_; }
+    /** @brief Records the ring keeps before overwriting. */
+    std::uint32_t capacity() const noexcept { return hdr_->capacity; }
+
+private:
+    void unmap() noexcept;
+
+    const struct simtemp_ring_hdr *hdr_ = nullptr;
+    std::size_t hdr_len_ = 0;
+    struct simtemp_ring_cursor *cursor_ = nullptr;
+    const Sample *records_ = nullptr;
+    std::uint64_t next_ = 0;        /* Sequence of the first record of the last peek() */
+    std::uint64_t dropped_ = 0;
+};
+
+/**
+ * @brief Waits on many devices with one epoll instance.
+ * Level-triggered; the devices must outlive their registration.
+ */
+class Multiplexer {
+public:
+    Multiplexer();
+    ~Multiplexer();
+
+    Multiplexer(const Multiplexer &) = delete;
+    Multiplexer &operator=(const Multiplexer &) = delete;
+
+    /** @brief Registers a device for @events (EPOLLIN, EPOLLPRI). */
+    void add(Device &dev, std::uint32_t events = EPOLLIN | EPOLLPRI);
+    /** @brief Unregisters a device. */
+    void remove(Device &dev);
+
+    /**
+     * @brief Waits for ready devices and calls @fn(Device &, events) for each.
+     * @param timeout_ms epoll_wait() timeout (-1 = forever).
+     * @param fn Handler.
+     * @return Number of ready devices (0 on timeout or EINTR).
+     */
+    template <typename F>
+    int wait(int timeout_ms, F &&fn)
+    {
+        int n = wait_events(timeout_ms);
+
+        for (int i = 0; i < n; i++)
+            fn(*static_cast<Device *>(events_[i].data.ptr), events_[i].events);
+        return n;
+    }
+
+private:
+    int wait_events(int timeout_ms);
+
+    int epfd_ = -1;
+    std::size_t count_ = 0;
+    std::vector<struct epoll_event> events_;
+};
+
+} // namespace simtemp
+
+#endif /* SIMTEMP_SIMTEMP_HPP_ */
@@ -0,0 +1,157 @@
+/**
+ * @file    device.cpp
+ * @author  Omar Mendiola
+ * @brief   libsimtemp: RAII device handle, batched read() and ioctls.
+ * @version 0.1
+ * @date    2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include "simtemp/simtemp.hpp"
+
+namespace simtemp {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string &what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+/* Instance number of a node path, for sorting */
+unsigned long instance_of(const std::string &path)
+{
+    return std::strtoul(path.c_str() + path.find_last_not_of("0123456789") + 1, nullptr, 10);
+}
+
+} // namespace
+
+Device::Device(const std::string &path, bool nonblock) : path_(path)
+{
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (nonblock ? O_NONBLOCK : 0));
+    if (fd_ < 0)
+        throw_errno("open " + path);
+}
+
+Device::~Device()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+Device::Device(Device &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), path_(std::move(other.path_))
+{
+}
+
+Device &Device::operator=(Device &&other) noexcept
+{
+    if (this != &other) {
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = std::exchange(other.fd_, -1);
+        path_ = std::move(other.path_);
+    }
+    return *this;
+}
+
+std::string Device::path_of(unsigned int instance)
+{
+    return "/dev/simtemp" + std::to_string(instance);
+}
+
+std::vector<std::string> Device::enumerate()
+{
+    std::vector<std::string> paths;
+    glob_t g;
+
+    if (::glob("/dev/simtemp[0-9]*", 0, nullptr, &g) == 0) {
+        paths.assign(g.gl_pathv, g.gl_pathv + g.gl_pathc);
+        ::globfree(&g);
+    }
+    std::sort(paths.begin(), paths.end(), [](const std::string &a, const std::string &b) {
+        return instance_of(a) < instance_of(b);
+    });
+    return paths;
+}
+
+std::string Device::sysfs_dir() const
+{
+    return "/sys/class/misc/" + path_.substr(path_.rfind('/') + 1);
+}
+
+SampleSpan Device::read(Sample *buf, std::size_t max)
+{
+    ssize_t len = ::read(fd_, buf, max * sizeof(Sample));
+
+    if (len < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return {};
+        throw_errno("read " + path_);
+    }
+    return {buf, static_cast<std::size_t>(len) / sizeof(Sample)};
+}
+
+SampleSpan Device::read_since(std::uint64_t since_ns, Sample *buf, std::size_t max)
+{
+    struct simtemp_read_batch req = {};
+
+    req.buf = reinterpret_cast<std::uintptr_t>(buf);
+    req.since_timestamp_ns = since_ns;
+    req.max = static_cast<std::uint32_t>(std::min<std::size_t>(max, UINT32_MAX));
+    if (::ioctl(fd_, SIMTEMP_IOC_READ_BATCH, &req) < 0)
+        throw_errno("SIMTEMP_IOC_READ_BATCH " + path_);
+    return {buf, req.count};
+}
+
+void Device::set_watermark(std::uint32_t samples, std::uint32_t max_latency_us)
+{
+    struct simtemp_watermark wm = {samples, max_latency_us};
+
+    if (::ioctl(fd_, SIMTEMP_IOC_SET_WATERMARK, &wm) < 0)
+        throw_errno("SIMTEMP_IOC_SET_WATERMARK " + path_);
+}
+
+void Device::set_format(std::uint32_t format)
+{
+    if (::ioctl(fd_, SIMTEMP_IOC_SET_FORMAT, &format) < 0)
+        throw_errno("SIMTEMP_IOC_SET_FORMAT " + path_);
+}
+
+void Device::ack_alert()
+{
+    if (::ioctl(fd_, SIMTEMP_IOC_ACK_ALERT) < 0)
+        throw_errno("SIMTEMP_IOC_ACK_ALERT " + path_);
+}
+
+std::uint64_t Device::stat(const std::string &name) const
+{
+    std::ifstream file(sysfs_dir() + "/stats");
+    std::string field;
+
+    if (!file)
+        throw std::system_error(ENOENT, std::generic_category(), sysfs_dir() + "/stats");
+    /* "updates=N alerts=N ... dropped=N ..." */
+    while (file >> field) {
+        if (field.compare(0, name.size() + 1, name + "=") == 0)
+            return std::stoull(field.substr(name.size() + 1));
+    }
+    throw std::system_error(EINVAL, std::generic_category(), "stats has no " + name);
+}
+
+} // namespace simtemp
@@ -0,0 +1,67 @@
+/**
+ * @file    multiplexer.cpp
+ * @author  Omar Mendiola
+ * @brief   libsimtemp: epoll multiplexer over many simtemp devices.
+ * @version 0.1
+ * @date    2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+#include "simtemp/simtemp.hpp"
+
+namespace simtemp {
+
+Multiplexer::Multiplexer()
+{
+    epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "epoll_create1");
+}
+
+Multiplexer::~Multiplexer()
+{
+    ::close(epfd_);
+}
+
+void Multiplexer::add(Device &dev, std::uint32_t events)
+{
+    struct epoll_event ev = {};
+
+    ev.events = events;
+    ev.data.ptr = &dev;
+    if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, dev.fd(), &ev) < 0)
+        throw std::system_error(errno, std::generic_category(), "epoll_ctl add " + dev.path());
+    events_.resize(++count_);
+}
+
+void Multiplexer::remove(Device &dev)
+{
+    if (::epoll_ctl(epfd_, EPOLL_CTL_DEL, dev.fd(), nullptr) < 0)
+        throw std::system_error(errno, std::generic_category(), "epoll_ctl del " + dev.path());
+    count_--;
+}
+
+int Multiplexer::wait_events(int timeout_ms)
+{
+    int n;
+
+    if (events_.empty())
+        events_.resize(1);
+    n = ::epoll_wait(epfd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+    if (n < 0) {
+        if (errno == EINTR)
+            return 0;
+        throw std::system_error(errno, std::generic_category(), "epoll_wait");
+    }
+    return n;
+}
+
+} // namespace simtemp
@@ -0,0 +1,157 @@
+/**
+ * @file    ring.cpp
+ * @author  Omar Mendiola
+ * @brief   libsimtemp: zero-copy reader of the mmap()ed sample ring.
+ * Follows the consumer protocol of struct simtemp_ring_hdr: acquire load
+ * of producer, use the records, read barrier, reload producer and discard
+ * the records it overwrote.
+ * @version 0.1
+ * @date    2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include "simtemp/simtemp.hpp"
+
+namespace simtemp {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string &what, int err = errno)
+{
+    throw std::system_error(err, std::generic_category(), what);
+}
+
+} // namespace
+
+Ring::Ring(const Device &dev)
+{
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    void *p;
+
+    /* The header tells how large the whole ring is */
+    p = ::mmap(nullptr, page, PROT_READ, MAP_SHARED, dev.fd(), SIMTEMP_MMAP_OFF_RING);
+    if (p == MAP_FAILED)
+        throw_errno("mmap ring header " + dev.path());
+    const auto *hdr = static_cast<const struct simtemp_ring_hdr *>(p);
+    if (hdr->magic != SIMTEMP_RING_MAGIC || hdr->version != SIMTEMP_RING_VERSION ||
+        hdr->record_size != sizeof(Sample)) {
+        ::munmap(p, page);
+        throw_errno("unsupported ring layout on " + dev.path(), EPROTO);
+    }
+    hdr_len_ = hdr->data_offset + static_cast<std::size_t>(hdr->slots) * sizeof(Sample);
+    ::munmap(p, page);
+
+    p = ::mmap(nullptr, hdr_len_, PROT_READ, MAP_SHARED, dev.fd(), SIMTEMP_MMAP_OFF_RING);
+    if (p == MAP_FAILED)
+        throw_errno("mmap ring " + dev.path());
+    hdr_ = static_cast<const struct simtemp_ring_hdr *>(p);
+    records_ = reinterpret_cast<const Sample *>(static_cast<const char *>(p) + hdr_->data_offset);
+
+    p = ::mmap(nullptr, sizeof(*cursor_), PROT_READ | PROT_WRITE, MAP_SHARED, dev.fd(),
+               SIMTEMP_MMAP_OFF_CURSOR);
+    if (p == MAP_FAILED) {
+        int err = errno;
+
+        unmap();
+        throw_errno("mmap cursor " + dev.path(), err);
+    }
+    cursor_ = static_cast<struct simtemp_ring_cursor *>(p);
+    next_ = __atomic_load_n(&cursor_->consumer, __ATOMIC_RELAXED);
+}
+
+Ring::~Ring()
+{
+    unmap();
+}
+
+Ring::Ring(Ring &&other) noexcept
+    : hdr_(std::exchange(other.hdr_, nullptr)), hdr_len_(other.hdr_len_),
+      cursor_(std::exchange(other.cursor_, nullptr)), records_(other.records_),
+      next_(other.next_), dropped_(other.dropped_)
+{
+}
+
+Ring &Ring::operator=(Ring &&other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        hdr_ = std::exchange(other.hdr_, nullptr);
+        hdr_len_ = other.hdr_len_;
+        cursor_ = std::exchange(other.cursor_, nullptr);
+        records_ = other.records_;
+        next_ = other.next_;
+        dropped_ = other.dropped_;
+    }
+    return *this;
+}
+
+void Ring::unmap() noexcept
+{
+    if (cursor_)
+        ::munmap(cursor_, sizeof(*cursor_));
+    if (hdr_)
+        ::munmap(const_cast<struct simtemp_ring_hdr *>(hdr_), hdr_len_);
+    cursor_ = nullptr;
+    hdr_ = nullptr;
+}
+
+SampleSpan Ring::peek(std::size_t max)
+{
+    std::uint64_t head = __atomic_load_n(&hdr_->producer, __ATOMIC_ACQUIRE);
+    std::uint64_t seq = __atomic_load_n(&cursor_->consumer, __ATOMIC_RELAXED);
+    std::uint64_t n, index;
+
+    if (static_cast<std::int64_t>(head - seq) <= 0) {
+        /* Up to date (or a cursor ahead of the producer): resync */
+        next_ = head;
+        return {};
+    }
+    if (head - seq > hdr_->capacity) {
+        /* Lapped: skip to the oldest stored record */
+        dropped_ += head - seq - hdr_->capacity;
+        seq = head - hdr_->capacity;
+    }
+
+    index = seq % hdr_->slots;
+    n = std::min<std::uint64_t>({head - seq, hdr_->slots - index, max});
+    next_ = seq;
+    return {records_ + index, static_cast<std::size_t>(n)};
+}
+
+std::size_t Ring::release(const SampleSpan &span)
+{
+    std::uint64_t head, lost = 0;
+
+    /* Finish using the records before rechecking producer */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    head = __atomic_load_n(&hdr_->producer, __ATOMIC_RELAXED);
+    if (head - next_ > hdr_->capacity)
+        lost = std::min<std::uint64_t>(head - next_ - hdr_->capacity, span.size);
+    dropped_ += lost;
+
+    next_ += span.size;
+    __atomic_store_n(&cursor_->consumer, next_, __ATOMIC_RELEASE);
+    return static_cast<std::size_t>(lost);
+}
+
+std::uint64_t Ring::pending() const noexcept
+{
+    std::uint64_t head = __atomic_load_n(&hdr_->producer, __ATOMIC_ACQUIRE);
+    std::uint64_t seq = __atomic_load_n(&cursor_->consumer, __ATOMIC_RELAXED);
+
+    if (static_cast<std::int64_t>(head - seq) <= 0)
+        return 0;
+    return std::min<std::uint64_t>(head - seq, hdr_->capacity);
+}
+
+} // namespace simtemp
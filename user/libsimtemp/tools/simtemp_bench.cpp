@@ -0,0 +1,231 @@
+/**
+ * @file    simtemp_bench.cpp
+ * @author  Omar Mendiola
+ * @brief   Throughput and delivery-latency benchmark built on libsimtemp.
+ * Consumes every sample of one or more simtemp devices through read() or
+ * the mmap()ed ring, multiplexed with epoll, and reports samples/s,
+ * p50/p99/max latency (CLOCK_MONOTONIC at consumption minus timestamp_ns)
+ * and losses. Latency is only meaningful with speed=1.
+ * @version 0.1
+ * @date    2025-10-29
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <getopt.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "simtemp/simtemp.hpp"
+
+namespace {
+
+constexpr std::size_t kBatch = 256;
+constexpr std::size_t kReservoir = 1 << 20;
+
+enum class Mode { Read, Mmap };
+
+struct Options {
+    double seconds = 10.0;
+    Mode mode = Mode::Read;
+    std::uint32_t lowat = 0;
+    std::uint32_t max_latency_us = 0;
+    std::vector<std::string> paths;
+};
+
+/* One consumer per device */
+struct Stream {
+    simtemp::Device dev;
+    std::unique_ptr<simtemp::Ring> ring;
+    std::uint64_t dropped_start = 0;
+};
+
+/* Uniform sample of the latencies (Algorithm R), bounded memory; the maximum is exact */
+class Reservoir {
+public:
+    void add(std::uint64_t ns)
+    {
+        seen_++;
+        max_ = std::max(max_, ns);
+        if (values_.size() < kReservoir) {
+            values_.push_back(ns);
+            return;
+        }
+        std::uint64_t j = std::uniform_int_distribution<std::uint64_t>(0, seen_ - 1)(rng_);
+        if (j < kReservoir)
+            values_[j] = ns;
+    }
+
+    std::uint64_t percentile(double p)
+    {
+        if (values_.empty())
+            return 0;
+        auto nth = values_.begin() + static_cast<std::ptrdiff_t>(p * (values_.size() - 1));
+        std::nth_element(values_.begin(), nth, values_.end());
+        return *nth;
+    }
+
+    std::uint64_t max() const { return max_; }
+
+private:
+    std::vector<std::uint64_t> values_;
+    std::uint64_t seen_ = 0;
+    std::uint64_t max_ = 0;
+    std::mt19937_64 rng_{0x5eed};
+};
+
+std::uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void usage(const char *prog)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [-t seconds] [-m read|mmap] [-w lowat] [-l max_latency_us] [device...]\n"
+                 "  -t  Run time (default 10)\n"
+                 "  -m  Consumption path (default read)\n"
+                 "  -w  Wake-up watermark in samples (SIMTEMP_IOC_SET_WATERMARK)\n"
+                 "  -l  Latency bound of the watermark in microseconds\n"
+                 "Devices default to every /dev/simtemp<N>.\n",
+                 prog);
+}
+
+bool parse_options(int argc, char **argv, Options &opt)
+{
+    int c;
+
+    while ((c = getopt(argc, argv, "t:m:w:l:h")) != -1) {
+        switch (c) {
+        case 't':
+            opt.seconds = std::strtod(optarg, nullptr);
+            break;
+        case 'm':
+            if (std::strcmp(optarg, "read") == 0)
+                opt.mode = Mode::Read;
+            else if (std::strcmp(optarg, "mmap") == 0)
+                opt.mode = Mode::Mmap;
+            else
+                return false;
+            break;
+        case 'w':
+            opt.lowat = static_cast<std::uint32_t>(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'l':
+            opt.max_latency_us = static_cast<std::uint32_t>(std::strtoul(optarg, nullptr, 10));
+            break;
+        default:
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; i++)
+        opt.paths.emplace_back(argv[i]);
+    if (opt.paths.empty())
+        opt.paths = simtemp::Device::enumerate();
+    return opt.seconds > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+
+    if (!parse_options(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (opt.paths.empty()) {
+        std::fprintf(stderr, "No simtemp device found (is the module loaded?)\n");
+        return 1;
+    }
+
+    try {
+        std::vector<std::unique_ptr<Stream>> streams;
+        simtemp::Multiplexer mux;
+        std::vector<simtemp::Sample> buf(kBatch);
+        std::vector<std::uint64_t> stamps;
+        Reservoir latencies;
+        std::uint64_t samples = 0, lost = 0, start, deadline, end;
+
+        for (const auto &path : opt.paths) {
+            auto s = std::make_unique<Stream>(Stream{simtemp::Device(path), nullptr, 0});
+
+            if (opt.lowat)
+                s->dev.set_watermark(opt.lowat, opt.max_latency_us);
+            if (opt.mode == Mode::Mmap)
+                s->ring = std::make_unique<simtemp::Ring>(s->dev);
+            else
+                s->dropped_start = s->dev.stat("dropped");
+            mux.add(s->dev, EPOLLIN);
+            streams.push_back(std::move(s));
+        }
+
+        start = now_ns();
+        deadline = start + static_cast<std::uint64_t>(opt.seconds * 1e9);
+        while (now_ns() < deadline) {
+            int timeout_ms = static_cast<int>((deadline - now_ns()) / 1000000) + 1;
+
+            mux.wait(timeout_ms, [&](simtemp::Device &dev, std::uint32_t) {
+                auto it = std::find_if(streams.begin(), streams.end(),
+                                       [&](const auto &s) { return &s->dev == &dev; });
+                Stream &s = **it;
+
+                if (s.ring) {
+                    for (auto span = s.ring->peek(kBatch); !span.empty(); span = s.ring->peek(kBatch)) {
+                        std::uint64_t t = now_ns();
+                        std::size_t skip;
+
+                        /* Take the timestamps before release() validates them */
+                        stamps.clear();
+                        for (const auto &sample : span)
+                            stamps.push_back(sample.timestamp_ns);
+                        skip = s.ring->release(span);
+                        for (std::size_t i = skip; i < stamps.size(); i++)
+                            latencies.add(t - stamps[i]);
+                        samples += span.size - skip;
+                    }
+                } else {
+                    for (auto span = dev.read(buf.data(), buf.size()); !span.empty();
+                         span = dev.read(buf.data(), buf.size())) {
+                        std::uint64_t t = now_ns();
+
+                        for (const auto &sample : span)
+                            latencies.add(t - sample.timestamp_ns);
+                        samples += span.size;
+                    }
+                }
+            });
+        }
+        end = now_ns();
+
+        for (const auto &s : streams)
+            lost += s->ring ? s->ring->dropped() : s->dev.stat("dropped") - s->dropped_start;
+
+        std::printf("devices:   %zu (%s)\n", streams.size(), opt.mode == Mode::Mmap ? "mmap" : "read");
+        std::printf("samples:   %" PRIu64 " (%.0f samples/s)\n", samples,
+                    samples / ((end - start) / 1e9));
+        std::printf("latency:   p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                    latencies.percentile(0.50) / 1e3, latencies.percentile(0.99) / 1e3,
+                    latencies.max() / 1e3);
+        std::printf("dropped:   %" PRIu64 "\n", lost);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "simtemp_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}